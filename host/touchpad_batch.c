@@ -0,0 +1,323 @@
+/******************************************************************************
+* File Name: touchpad_batch.c
+*
+* Description: Batch reconstruction of the touchpad touch status and positions
+* from captured difference counts, see touchpad_batch.h.
+*
+* The processing of a frame in the firmware has two parts:
+*  - the search of the local maxima, the selection of the strongest ones and
+*    their centroids, which depend only on the frame and the threshold
+*  - the threshold selection by the touch status of the previous frame, and
+*    the debounce, which depend on the previous frames
+* The threshold while the touchpad is active is the lower one, and the
+* strongest maxima above the higher one are the first ones of the maxima above
+* the lower one, in the same order. So the first part is computed once per
+* frame with the lower threshold, split between threads: the search runs on
+* many frames at a time in the lanes of vectors, and the centroids are computed
+* for the maxima found. The second part is a short sequential pass over the
+* frames.
+*
+*******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "touchpad_batch.h"
+
+/* 128-bit vectors of 16-bit lanes, one frame per lane, and the lane masks of their comparisons */
+typedef uint16_t vu16_t __attribute__((vector_size(16)));
+typedef int16_t vmask_t __attribute__((vector_size(16)));
+
+#define LANES                   (sizeof(vu16_t) / sizeof(uint16_t))
+
+/* Span of the centroid in 1/256 node pitches */
+#define X_SPAN                  ((TOUCHPAD_BATCH_NUM_COLS - 1u) << 8u)
+#define Y_SPAN                  ((TOUCHPAD_BATCH_NUM_ROWS - 1u) << 8u)
+
+/* Strongest local maxima of a frame above the lower threshold, zero if none, and their positions */
+typedef struct
+{
+    uint16_t peak[TOUCHPAD_BATCH_NUM_TOUCHES];
+    touchpad_batch_position_t position[TOUCHPAD_BATCH_NUM_TOUCHES];
+} candidates_t;
+
+typedef struct
+{
+    const touchpad_batch_frame_t *frames;
+    candidates_t *candidates;
+    uint32_t count;
+    uint16_t threshold;
+    pthread_t thread;
+    uint32_t started;
+} worker_t;
+
+/* Lanes of a where mask is set, of b elsewhere */
+static inline vu16_t select_lanes(vmask_t mask, vu16_t a, vu16_t b)
+{
+    return (a & (vu16_t)mask) | (b & ~(vu16_t)mask);
+}
+
+/* Non-zero if the mask is set in any lane */
+static inline uint64_t any_lane(vmask_t mask)
+{
+    uint64_t half[2];
+
+    memcpy(half, &mask, sizeof(half));
+    return half[0] | half[1];
+}
+
+/*******************************************************************************
+* Centroid of the local maximum at column col and row row of a bordered
+* frame, with the integer arithmetic of the firmware
+*******************************************************************************/
+static touchpad_batch_position_t get_centroid(const vu16_t (*diff)[TOUCHPAD_BATCH_NUM_ROWS + 2u], uint32_t lane,
+                                              uint32_t col, uint32_t row, uint32_t id)
+{
+    touchpad_batch_position_t position;
+    uint32_t sum = 0u;
+    int32_t x = 0;
+    int32_t y = 0;
+    uint32_t i;
+
+    for (i = 0u; i < 3u; i++)
+    {
+        sum += (uint32_t)diff[col - 1u][row - 1u + i][lane] + diff[col][row - 1u + i][lane] +
+               diff[col + 1u][row - 1u + i][lane];
+        x += (int32_t)diff[col + 1u][row - 1u + i][lane] - (int32_t)diff[col - 1u][row - 1u + i][lane];
+        y += (int32_t)diff[col - 1u + i][row + 1u][lane] - (int32_t)diff[col - 1u + i][row - 1u][lane];
+    }
+
+    x = (int32_t)((col - 1u) << 8u) + ((x * 256) / (int32_t)sum);
+    y = (int32_t)((row - 1u) << 8u) + ((y * 256) / (int32_t)sum);
+    x = (x < 0) ? 0 : ((x > (int32_t)X_SPAN) ? (int32_t)X_SPAN : x);
+    y = (y < 0) ? 0 : ((y > (int32_t)Y_SPAN) ? (int32_t)Y_SPAN : y);
+
+    position.x = (uint16_t)((((uint32_t)x * TOUCHPAD_BATCH_MAX_POSITION) + (X_SPAN / 2u)) / X_SPAN);
+    position.y = (uint16_t)((((uint32_t)y * TOUCHPAD_BATCH_MAX_POSITION) + (Y_SPAN / 2u)) / Y_SPAN);
+    position.z = (uint16_t)((sum > UINT16_MAX) ? UINT16_MAX : sum);
+    position.id = (uint16_t)id;
+
+    return position;
+}
+
+/*******************************************************************************
+* Finds the two strongest local maxima at or above the threshold and their
+* centroids in the given frames. The search runs on LANES frames at a time;
+* as in the firmware, the nodes below the threshold are skipped early, here
+* when they are below it in all lanes. The centroids are computed for the
+* lanes with a maximum only
+*******************************************************************************/
+static void find_candidates(const touchpad_batch_frame_t *frames, uint32_t count, uint16_t threshold,
+                            candidates_t *candidates)
+{
+    static const touchpad_batch_frame_t zeroFrame;
+
+    /* Difference counts with a border of zeros, one frame per lane */
+    vu16_t diff[TOUCHPAD_BATCH_NUM_COLS + 2u][TOUCHPAD_BATCH_NUM_ROWS + 2u];
+    const uint16_t *frame[LANES];
+    vu16_t peak[TOUCHPAD_BATCH_NUM_TOUCHES];
+    vu16_t node[TOUCHPAD_BATCH_NUM_TOUCHES];
+    candidates_t *ptrCandidates;
+    vu16_t d;
+    vu16_t value;
+    vmask_t above0;
+    vmask_t above1;
+    vu16_t index;
+    uint32_t base;
+    uint32_t lanes;
+    uint32_t lane;
+    uint32_t col;
+    uint32_t row;
+    uint32_t n;
+    uint32_t i;
+
+    _Static_assert(8u == LANES, "the lane loads assume 8 lanes");
+
+    memset(diff, 0, sizeof(diff));
+
+    for (base = 0u; base < count; base += LANES)
+    {
+        /* The lanes after the last frame process a frame of zeros */
+        lanes = ((count - base) < LANES) ? (count - base) : LANES;
+        for (lane = 0u; lane < LANES; lane++)
+        {
+            frame[lane] = (lane < lanes) ? frames[base + lane] : zeroFrame;
+        }
+
+        for (col = 0u; col < TOUCHPAD_BATCH_NUM_COLS; col++)
+        {
+            for (row = 0u; row < TOUCHPAD_BATCH_NUM_ROWS; row++)
+            {
+                n = (col * TOUCHPAD_BATCH_NUM_ROWS) + row;
+                diff[col + 1u][row + 1u] = (vu16_t){ frame[0][n], frame[1][n], frame[2][n], frame[3][n],
+                                                     frame[4][n], frame[5][n], frame[6][n], frame[7][n] };
+            }
+        }
+
+        for (i = 0u; i < TOUCHPAD_BATCH_NUM_TOUCHES; i++)
+        {
+            peak[i] = (vu16_t){ 0 };
+            node[i] = (vu16_t){ 0 };
+        }
+
+        for (col = 1u; col <= TOUCHPAD_BATCH_NUM_COLS; col++)
+        {
+            for (row = 1u; row <= TOUCHPAD_BATCH_NUM_ROWS; row++)
+            {
+                d = diff[col][row];
+                if (0u == any_lane(d >= threshold))
+                {
+                    continue;
+                }
+
+                /* Local maximum as in the firmware: above the nodes before it in the sensor order, not below the
+                 * others. The maxima are not zero, as they exceed the border */
+                value = d & (vu16_t)((d >= threshold) &
+                                     (d > diff[col - 1u][row - 1u]) & (d > diff[col - 1u][row]) &
+                                     (d > diff[col - 1u][row + 1u]) & (d > diff[col][row - 1u]) &
+                                     (d >= diff[col][row + 1u]) & (d >= diff[col + 1u][row - 1u]) &
+                                     (d >= diff[col + 1u][row]) & (d >= diff[col + 1u][row + 1u]));
+                if (0u == any_lane(value != 0))
+                {
+                    continue;
+                }
+
+                /* Insert in the two strongest, after the earlier nodes of the same value */
+                index = (vu16_t){ 0 } + (uint16_t)((col << 8u) | row);
+                above0 = value > peak[0];
+                above1 = value > peak[1];
+
+                peak[1] = select_lanes(above0, peak[0], select_lanes(above1, value, peak[1]));
+                node[1] = select_lanes(above0, node[0], select_lanes(above1, index, node[1]));
+                peak[0] = select_lanes(above0, value, peak[0]);
+                node[0] = select_lanes(above0, index, node[0]);
+            }
+        }
+
+        for (lane = 0u; lane < lanes; lane++)
+        {
+            ptrCandidates = &candidates[base + lane];
+            for (i = 0u; i < TOUCHPAD_BATCH_NUM_TOUCHES; i++)
+            {
+                ptrCandidates->peak[i] = peak[i][lane];
+                if (0u != peak[i][lane])
+                {
+                    ptrCandidates->position[i] = get_centroid(diff, lane, node[i][lane] >> 8u, node[i][lane] & 0xFFu, i);
+                }
+            }
+        }
+    }
+}
+
+static void *run_worker(void *arg)
+{
+    worker_t *worker = (worker_t *)arg;
+
+    find_candidates(worker->frames, worker->count, worker->threshold, worker->candidates);
+    return NULL;
+}
+
+/*******************************************************************************
+* Function Name: touchpad_batch_process
+*******************************************************************************/
+int touchpad_batch_process(const touchpad_batch_config_t *config, const touchpad_batch_frame_t *frames,
+                           uint32_t count, uint32_t threads, touchpad_batch_status_t *state,
+                           touchpad_batch_status_t *results)
+{
+    candidates_t *candidates;
+    worker_t *workers;
+    uint32_t lowThreshold;
+    uint32_t highThreshold;
+    uint32_t threshold;
+    uint32_t chunk;
+    uint32_t start;
+    uint32_t touches;
+    uint32_t i;
+    uint32_t k;
+
+    if (0u == count)
+    {
+        return 0;
+    }
+
+    threads = (0u == threads) ? 1u : threads;
+    candidates = malloc(count * sizeof(candidates_t));
+    workers = malloc(threads * sizeof(worker_t));
+    if ((NULL == candidates) || (NULL == workers))
+    {
+        free(candidates);
+        free(workers);
+        return -1;
+    }
+
+    lowThreshold = (config->fingerTh > config->hysteresis) ? ((uint32_t)config->fingerTh - config->hysteresis) : 0u;
+    highThreshold = (uint32_t)config->fingerTh + config->hysteresis;
+
+    /* Chunks of whole vectors, the last worker runs in the calling thread */
+    chunk = (((count + LANES - 1u) / LANES + threads - 1u) / threads) * LANES;
+    for (i = 0u; i < threads; i++)
+    {
+        start = ((i * chunk) < count) ? (i * chunk) : count;
+        workers[i].frames = &frames[start];
+        workers[i].candidates = &candidates[start];
+        workers[i].count = ((count - start) < chunk) ? (count - start) : chunk;
+        workers[i].threshold = (uint16_t)lowThreshold;
+    }
+    for (i = 0u; (i + 1u) < threads; i++)
+    {
+        workers[i].started = (0 == pthread_create(&workers[i].thread, NULL, run_worker, &workers[i])) ? 1u : 0u;
+        if (0u == workers[i].started)
+        {
+            /* Run the chunk here if no thread is available */
+            run_worker(&workers[i]);
+        }
+    }
+    run_worker(&workers[threads - 1u]);
+    for (i = 0u; (i + 1u) < threads; i++)
+    {
+        if (0u != workers[i].started)
+        {
+            pthread_join(workers[i].thread, NULL);
+        }
+    }
+
+    /* Threshold from the status of the previous frame and debounce, in order */
+    for (i = 0u; i < count; i++)
+    {
+        threshold = (0u != state->active) ? lowThreshold : highThreshold;
+        touches = 0u;
+        while ((touches < TOUCHPAD_BATCH_NUM_TOUCHES) && (0u != candidates[i].peak[touches]) &&
+               (candidates[i].peak[touches] >= threshold))
+        {
+            touches++;
+        }
+
+        if (0u == touches)
+        {
+            state->debounce = 0u;
+            state->active = 0u;
+        }
+        else
+        {
+            if (state->debounce < config->onDebounce)
+            {
+                state->debounce++;
+            }
+            if (state->debounce >= config->onDebounce)
+            {
+                state->active = 1u;
+            }
+        }
+
+        state->numPosition = (0u != state->active) ? (uint8_t)touches : 0u;
+        memset(state->position, 0, sizeof(state->position));
+        for (k = 0u; k < state->numPosition; k++)
+        {
+            state->position[k] = candidates[i].position[k];
+        }
+        results[i] = *state;
+    }
+
+    free(workers);
+    free(candidates);
+    return 0;
+}
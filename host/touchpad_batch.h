@@ -0,0 +1,67 @@
+/******************************************************************************
+* File Name: touchpad_batch.h
+*
+* Description: Host library reconstructing the touch status and positions of
+* the 4 x 5 CSX touchpad from captured difference counts, with the integer
+* semantics of the specialized touchpad processing of the firmware
+* (update_touchpad_status() in main.c, ENABLE_TOUCHPAD_SPECIALIZED_PROCESSING).
+* The frames are processed in batches with vector instructions and worker
+* threads; the results are bit-exact with the specialized processing, which is
+* checked by test/test_touchpad_batch. The library reproduces the specialized
+* processing only: it is not checked against the generic middleware
+* processing of the default build. That agreement is checked on the device
+* with ENABLE_TOUCHPAD_PROCESSING_CHECK, or against captured middleware results
+* by test/test_touchpad_processing.
+*
+*******************************************************************************/
+#ifndef TOUCHPAD_BATCH_H
+#define TOUCHPAD_BATCH_H
+
+#include <stdint.h>
+
+/* Touchpad geometry and position resolution of the firmware */
+#define TOUCHPAD_BATCH_NUM_COLS         (4u)
+#define TOUCHPAD_BATCH_NUM_ROWS         (5u)
+#define TOUCHPAD_BATCH_NUM_SNS          (TOUCHPAD_BATCH_NUM_COLS * TOUCHPAD_BATCH_NUM_ROWS)
+#define TOUCHPAD_BATCH_NUM_TOUCHES      (2u)
+#define TOUCHPAD_BATCH_MAX_POSITION     (255u)
+
+/* Touchpad thresholds of the capture, as in the widget data */
+typedef struct
+{
+    uint16_t fingerTh;
+    uint16_t hysteresis;
+    uint8_t onDebounce;
+} touchpad_batch_config_t;
+
+typedef struct
+{
+    uint16_t x;
+    uint16_t y;
+    uint16_t z;
+    uint16_t id;
+} touchpad_batch_position_t;
+
+/* Touch status of a frame. The positions after numPosition are zero */
+typedef struct
+{
+    uint8_t active;
+    uint8_t numPosition;
+    uint8_t debounce;
+    touchpad_batch_position_t position[TOUCHPAD_BATCH_NUM_TOUCHES];
+} touchpad_batch_status_t;
+
+/* Difference counts of one frame; the node at column col and row row is col * TOUCHPAD_BATCH_NUM_ROWS + row */
+typedef uint16_t touchpad_batch_frame_t[TOUCHPAD_BATCH_NUM_SNS];
+
+/* Processes count consecutive frames of one capture with up to the given
+ * number of threads, including the calling one. state is the status before
+ * the first frame, zero at the start of a capture, and is updated with the
+ * status of the last frame, so a capture can be processed in parts. results
+ * receives the status of every frame. Returns 0, or -1 if the working memory
+ * cannot be allocated */
+int touchpad_batch_process(const touchpad_batch_config_t *config, const touchpad_batch_frame_t *frames,
+                           uint32_t count, uint32_t threads, touchpad_batch_status_t *state,
+                           touchpad_batch_status_t *results);
+
+#endif /* TOUCHPAD_BATCH_H */
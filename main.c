@@ -17,6 +17,7 @@
 #include "cybsp.h"
 #include "cycfg.h"
 #include "cycfg_capsense.h"
+#include <string.h>
 
 /*******************************************************************************
 * User Configurable Macro
@@ -28,9 +29,22 @@
 /*Enables the Runtime measurement functionality used to for processing time measurement */
 #define ENABLE_RUN_TIME_MEASUREMENT     (0u)
 
+/* Process only the touchpad, the single widget scanned in ACTIVE and ALR modes, and compute its touch status and
+ * positions with a processing specialized for the 4 x 5 CSX touchpad in place of the generic one of the middleware */
+#define ENABLE_TOUCHPAD_SPECIALIZED_PROCESSING  (0u)
+
+/* Also run the generic touchpad status processing in every frame and compare its results bit by bit with the
+ * specialized one. The generic results are used. The comparison and the processing cycles of both are exposed on
+ * the EZI2C secondary slave address */
+#define ENABLE_TOUCHPAD_PROCESSING_CHECK        (0u)
+
 /* Enable this, if Tuner needs to be enabled */
 #define ENABLE_TUNER                    (1u)
 
+/* Expose double-buffered snapshots of the Tuner data, so the host always reads complete frames. The snapshots take
+ * 2 x sizeof(cy_capsense_tuner) of RAM */
+#define ENABLE_TUNER_SNAPSHOT           (1u)
+
 /*Enable PWM controlled LEDs*/
 #define ENABLE_PWM_LED                  (1u)
 
@@ -46,6 +60,10 @@
 /* Timeout to move from ALR mode to WOT mode if there is no user activity */
 #define ALR_MODE_TIMEOUT_SEC            (5u)
 
+/* Wake-On-Touch scan interval in us and number of scans before timeout, as set in the CAPSENSE Configurator */
+#define WOT_MODE_SCAN_INTERVAL          (62500u)
+#define WOT_MODE_TIMEOUT_SCANS          (160u)
+
 /* Active mode Scan time calculated in us ~= 923us */
 #define ACTIVE_MODE_FRAME_SCAN_TIME     (923u)
 
@@ -59,6 +77,92 @@
 #define ALR_MODE_PROCESS_TIME           (184u)
 
 #define MAXIMUM_BRIGHTNESS_LED          (255u)
+
+/* Enable the idle-time scheduler for the housekeeping tasks (LED, Tuner) run after frame processing */
+#define ENABLE_IDLE_TASK_SCHEDULER      (1u)
+
+/* Active mode time in us reserved in every frame for the idle-time tasks */
+#define ACTIVE_MODE_TASK_BUDGET         (200u)
+
+/* ALR mode time in us reserved in every frame for the idle-time tasks */
+#define ALR_MODE_TASK_BUDGET            (200u)
+
+/* Enable power state telemetry, exposed on the EZI2C secondary slave address */
+#define ENABLE_TELEMETRY                (1u)
+
+/* Enable tracking of up to two touches with persistent IDs, exposed on the EZI2C secondary slave address */
+#define ENABLE_MULTI_TOUCH              (0u)
+
+/* Maximum position change between frames for a touch to keep its ID */
+#define MULTI_TOUCH_MAX_DISTANCE        (64u)
+
+/* Enable the alpha-beta filter that smooths and extrapolates the reported touch position, exposed on the EZI2C
+ * secondary slave address with the raw position */
+#define ENABLE_POSITION_FILTER          (0u)
+
+/* Position filter gains in 1/256 units. Higher values follow the finger with less lag,
+ * lower values remove more jitter but overshoot more when the finger stops */
+#define POSITION_FILTER_ALPHA           (160u)
+#define POSITION_FILTER_BETA            (48u)
+
+/* Position extrapolation in 1/256 frames, i.e. the expected delay until the position is used */
+#define POSITION_FILTER_LEAD            (256u)
+
+/* Touchpad maximum position, as set in the CAPSENSE Configurator */
+#define TOUCHPAD_MAX_POSITION           (255u)
+
+/* Touchpad columns and rows, as set in the CAPSENSE Configurator */
+#define TOUCHPAD_NUM_COLS               (4u)
+#define TOUCHPAD_NUM_ROWS               (5u)
+
+/* Enable one-finger scroll with momentum and dial gestures, exposed on the EZI2C secondary slave address */
+#define ENABLE_GESTURE_EXTENSION        (0u)
+
+/* Finger movement from touchdown that starts scrolling */
+#define SCROLL_START_DISTANCE           (16u)
+
+/* Minimum liftoff speed in positions per second that starts the momentum scroll (fling) */
+#define FLING_MIN_SPEED                 (250u)
+
+/* Momentum speed kept per frame in 1/256 units, and the speed in positions per second that stops it */
+#define FLING_DECAY                     (243u)
+#define FLING_STOP_SPEED                (16u)
+
+/* Minimum distance from the touchpad center of a touchdown that starts the dial gesture */
+#define DIAL_MIN_RADIUS                 (88u)
+
+/* Enable the CPU wake-up to ISR entry and ISR execution time histograms, exposed on the EZI2C secondary slave
+ * address */
+#define ENABLE_ISR_LATENCY              (0u)
+
+/* Width of the histogram buckets in us. The last bucket collects all longer times */
+#define LATENCY_BUCKET_WIDTH            (8u)
+
+/* Enable the frame jitter report binned by the EZI2C host traffic, exposed on the EZI2C secondary slave address */
+#define ENABLE_FRAME_JITTER             (0u)
+
+/* EZI2C interrupts per frame covered by each host load bin. The last bin collects all heavier loads */
+#define JITTER_LOAD_BIN_WIDTH           (4u)
+
+/* Enable the sleep manager that selects CPU Sleep or Deep Sleep for every idle period */
+#define ENABLE_SLEEP_MANAGER            (1u)
+
+/* Deep Sleep wake-up time in us from the device datasheet. Not measurable as the SysTick stops in Deep Sleep */
+#define DEEP_SLEEP_WAKEUP_TIME          (25u)
+
+/* Initial estimate of the CPU time in us spent in a Deep Sleep entry and exit, including the callbacks */
+#define DEEP_SLEEP_TRANSITION_TIME      (40u)
+
+/* With the PWM LEDs, also use Deep Sleep in ACTIVE mode while all the LEDs are off; otherwise ACTIVE mode uses CPU
+ * Sleep as without the sleep manager. The gesture timestamp is then advanced by the Deep Sleep time measured with
+ * the ILO, which can be one timestamp interval off and shift the double click window */
+#define ENABLE_ACTIVE_DEEP_SLEEP        (0u)
+
+/* Enable the ILO timebase that times the WOT frames for the telemetry and the idle periods for the sleep manager.
+ * It runs the WDT, a reset source, and its interrupt wakes the CPU every 2^16 ILO cycles, about 1.6 s, also in WOT
+ * mode. Without it the telemetry counts a WOT frame ended by a touch as half a frame, and the sleep manager uses
+ * Deep Sleep whenever the EZI2C and the PWM allow it */
+#define ENABLE_ILO_TIMEBASE             (0u)
 /*******************************************************************************
 * Fixed Macros
 *******************************************************************************/
@@ -74,17 +178,26 @@
 #define ILO_FREQ                        (40000u)
 #define TIME_IN_US                      (1000000u)
 
+/* Time reserved for the idle-time tasks is added to the frame processing time */
+#if ENABLE_IDLE_TASK_SCHEDULER
+#define ACTIVE_MODE_FRAME_PROCESS_TIME  (ACTIVE_MODE_PROCESS_TIME + ACTIVE_MODE_TASK_BUDGET)
+#define ALR_MODE_FRAME_PROCESS_TIME     (ALR_MODE_PROCESS_TIME + ALR_MODE_TASK_BUDGET)
+#else
+#define ACTIVE_MODE_FRAME_PROCESS_TIME  (ACTIVE_MODE_PROCESS_TIME)
+#define ALR_MODE_FRAME_PROCESS_TIME     (ALR_MODE_PROCESS_TIME)
+#endif
+
 #define MINIMUM_TIMER                   (TIME_IN_US / ILO_FREQ)
-#if ((TIME_IN_US / ACTIVE_MODE_REFRESH_RATE) > (ACTIVE_MODE_FRAME_SCAN_TIME + ACTIVE_MODE_PROCESS_TIME))
+#if ((TIME_IN_US / ACTIVE_MODE_REFRESH_RATE) > (ACTIVE_MODE_FRAME_SCAN_TIME + ACTIVE_MODE_FRAME_PROCESS_TIME))
 #define ACTIVE_MODE_TIMER           (TIME_IN_US / ACTIVE_MODE_REFRESH_RATE - \
-        (ACTIVE_MODE_FRAME_SCAN_TIME + ACTIVE_MODE_PROCESS_TIME))
+        (ACTIVE_MODE_FRAME_SCAN_TIME + ACTIVE_MODE_FRAME_PROCESS_TIME))
 #elif
 #define ACTIVE_MODE_TIMER           (MINIMUM_TIMER)
 #endif
 
-#if ((TIME_IN_US / ALR_MODE_REFRESH_RATE) > (ALR_MODE_FRAME_SCAN_TIME + ALR_MODE_PROCESS_TIME))
+#if ((TIME_IN_US / ALR_MODE_REFRESH_RATE) > (ALR_MODE_FRAME_SCAN_TIME + ALR_MODE_FRAME_PROCESS_TIME))
 #define ALR_MODE_TIMER              (TIME_IN_US / ALR_MODE_REFRESH_RATE - \
-        (ALR_MODE_FRAME_SCAN_TIME + ALR_MODE_PROCESS_TIME))
+        (ALR_MODE_FRAME_SCAN_TIME + ALR_MODE_FRAME_PROCESS_TIME))
 #elif
 #define ALR_MODE_TIMER              (MINIMUM_TIMER)
 #endif
@@ -103,6 +216,171 @@
 #define SYS_TICK_INTERVAL           (TIMESTAMP_INTERVAL_IN_MILSEC*1000/(TIME_PER_TICK_IN_US))
 #endif
 
+#if (ENABLE_RUN_TIME_MEASUREMENT || CY_CAPSENSE_GESTURE_EN)
+/* SysTick counts CPU clock cycles, used for sub-frame time measurements */
+#define SYS_TICK_PER_US             (CY_CAPSENSE_CPU_CLK / TIME_IN_US)
+#endif
+
+/* Macros Related to the power state telemetry */
+#if ENABLE_TELEMETRY
+#define TELEMETRY_STATE_COUNT           (3u)
+#define TELEMETRY_STATE_INDEX(state)    ((uint32_t)(state) - (uint32_t)ACTIVE_MODE)
+
+/* Duration in us of a Wake-On-Touch frame ended by the timeout */
+#define WOT_MODE_FRAME_TIME             ((uint64_t)WOT_MODE_SCAN_INTERVAL * WOT_MODE_TIMEOUT_SCANS)
+#endif
+
+/* Macros Related to the ILO timebase. The WDT counter is clocked by the ILO and keeps
+ * counting in Deep Sleep, it times the WOT frames and the idle periods that the SysTick
+ * cannot measure */
+#if ENABLE_ILO_TIMEBASE
+#define WDT_INTR_PRIORITY               (3u)
+
+/* The WDT counter is 16 bits wide, its wraps are counted to extend it */
+#define WDT_COUNTER_BITS                (16u)
+#endif
+
+/* Macros Related to the multi-touch tracking */
+#if ENABLE_MULTI_TOUCH
+#define MULTI_TOUCH_MAX_CONTACTS        (2u)
+#define MULTI_TOUCH_NO_MATCH            (0xFFu)
+
+/* Contact flags */
+#define CONTACT_FLAG_TOUCHDOWN          (0x01u)
+#define CONTACT_FLAG_LIFTOFF            (0x02u)
+#endif
+
+/* Macros Related to the gesture extension */
+#if ENABLE_GESTURE_EXTENSION
+#define TOUCHPAD_CENTER                 ((int32_t)TOUCHPAD_MAX_POSITION / 2)
+
+/* Speeds converted to 1/256 positions per frame */
+#define FLING_MIN_VELOCITY              ((int32_t)((FLING_MIN_SPEED * 256u) / ACTIVE_MODE_REFRESH_RATE))
+#define FLING_STOP_VELOCITY             ((int32_t)((FLING_STOP_SPEED * 256u) / ACTIVE_MODE_REFRESH_RATE))
+
+/* Weight of the last frame in the velocity estimate in 1/256 units */
+#define GESTURE_VELOCITY_WEIGHT         (96)
+
+/* Radians to 0.1 degrees */
+#define RADIAN_TO_DECIDEGREE            (573)
+
+/* Resolution of the dial rotation accumulated between frames, in units per 0.1 degree.
+ * The product with the largest cross product of two positions fits in 32 bits */
+#define ROTATION_SUBUNITS               (64)
+#endif
+
+/* Macros Related to the sleep manager */
+#if ENABLE_SLEEP_MANAGER
+/* Time from the start of the idle period until the end of the scan */
+#define ACTIVE_MODE_IDLE_WINDOW         (ACTIVE_MODE_TIMER + ACTIVE_MODE_FRAME_SCAN_TIME)
+#define ALR_MODE_IDLE_WINDOW            (ALR_MODE_TIMER + ALR_MODE_FRAME_SCAN_TIME)
+#define WOT_MODE_IDLE_WINDOW            (WOT_MODE_SCAN_INTERVAL)
+
+/* Nominal ILO cycles per ms in 1/256 units, and the range of the estimate measured on
+ * the frames. Measurements outside the range are discarded */
+#define ILO_TICKS_PER_MS_NOMINAL        ((ILO_FREQ * 256u) / 1000u)
+#define ILO_TICKS_PER_MS_MIN            (ILO_TICKS_PER_MS_NOMINAL / 2u)
+#define ILO_TICKS_PER_MS_MAX            (ILO_TICKS_PER_MS_NOMINAL * 2u)
+
+/* The custom callback only runs after the transition to timestamp the Deep Sleep exit */
+#define DEEP_SLEEP_CB_SKIP_MODE         (CY_SYSPM_SKIP_CHECK_READY | CY_SYSPM_SKIP_CHECK_FAIL | \
+                                         CY_SYSPM_SKIP_BEFORE_TRANSITION)
+#else
+#define DEEP_SLEEP_CB_SKIP_MODE         (0UL)
+#endif
+
+#if (ENABLE_SLEEP_MANAGER && ENABLE_ACTIVE_DEEP_SLEEP && !ENABLE_ILO_TIMEBASE)
+#error "ENABLE_ACTIVE_DEEP_SLEEP requires ENABLE_ILO_TIMEBASE to advance the gesture timestamp over the Deep Sleep"
+#endif
+
+/* Macros Related to the interrupt latency measurement */
+#if ENABLE_ISR_LATENCY
+#if !(ENABLE_RUN_TIME_MEASUREMENT || CY_CAPSENSE_GESTURE_EN)
+#error "ENABLE_ISR_LATENCY requires the SysTick, enabled by ENABLE_RUN_TIME_MEASUREMENT or gestures"
+#endif
+
+#define LATENCY_HISTOGRAM_BUCKETS       (16u)
+#endif
+
+/* Macros Related to the frame jitter measurement */
+#if ENABLE_FRAME_JITTER
+#if !(ENABLE_RUN_TIME_MEASUREMENT || CY_CAPSENSE_GESTURE_EN)
+#error "ENABLE_FRAME_JITTER requires the SysTick, enabled by ENABLE_RUN_TIME_MEASUREMENT or gestures"
+#endif
+
+#define JITTER_LOAD_BINS                (8u)
+#endif
+
+/* Macros Related to the specialized touchpad processing */
+#if ENABLE_TOUCHPAD_SPECIALIZED_PROCESSING
+/* Middleware processing stages run before the specialized touch status: filters, baseline and difference counts */
+#define TOUCHPAD_RAW_COUNT_STAGES       (CY_CAPSENSE_PROCESS_ALL & ~CY_CAPSENSE_PROCESS_STATUS)
+
+/* Centroid positions are in 1/256 node pitches, scaled to the maximum position over the node span */
+#define TOUCHPAD_X_SPAN                 ((TOUCHPAD_NUM_COLS - 1u) << 8u)
+#define TOUCHPAD_Y_SPAN                 ((TOUCHPAD_NUM_ROWS - 1u) << 8u)
+#endif
+
+#if ENABLE_TOUCHPAD_PROCESSING_CHECK
+#if !ENABLE_TOUCHPAD_SPECIALIZED_PROCESSING
+#error "ENABLE_TOUCHPAD_PROCESSING_CHECK requires ENABLE_TOUCHPAD_SPECIALIZED_PROCESSING"
+#endif
+#if !(ENABLE_RUN_TIME_MEASUREMENT || CY_CAPSENSE_GESTURE_EN)
+#error "ENABLE_TOUCHPAD_PROCESSING_CHECK requires the SysTick, enabled by ENABLE_RUN_TIME_MEASUREMENT or gestures"
+#endif
+#endif
+
+/* Data exposed to the host on the EZI2C secondary slave address */
+#define ENABLE_HOST_INTERFACE           (ENABLE_TELEMETRY || ENABLE_MULTI_TOUCH || ENABLE_POSITION_FILTER || \
+                                         ENABLE_GESTURE_EXTENSION || ENABLE_ISR_LATENCY || ENABLE_SLEEP_MANAGER || \
+                                         ENABLE_FRAME_JITTER || ENABLE_TOUCHPAD_PROCESSING_CHECK)
+
+#if ENABLE_HOST_INTERFACE
+/* Layout version of HOST_INTERFACE, incremented on every change of a block layout */
+#define HOST_INTERFACE_VERSION          (2u)
+
+/* Feature mask bits of the blocks present in HOST_INTERFACE. The present blocks
+ * follow the header in the order of the bits */
+#define HOST_FEATURE_TELEMETRY          (0x0001u)
+#define HOST_FEATURE_MULTI_TOUCH        (0x0002u)
+#define HOST_FEATURE_POSITION_FILTER    (0x0004u)
+#define HOST_FEATURE_GESTURE_EXTENSION  (0x0008u)
+#define HOST_FEATURE_ISR_LATENCY        (0x0010u)
+#define HOST_FEATURE_SLEEP_MANAGER      (0x0020u)
+#define HOST_FEATURE_FRAME_JITTER       (0x0040u)
+#define HOST_FEATURE_TOUCHPAD_CHECK     (0x0080u)
+
+#define HOST_INTERFACE_FEATURES         ((ENABLE_TELEMETRY ? HOST_FEATURE_TELEMETRY : 0u) | \
+                                         (ENABLE_MULTI_TOUCH ? HOST_FEATURE_MULTI_TOUCH : 0u) | \
+                                         (ENABLE_POSITION_FILTER ? HOST_FEATURE_POSITION_FILTER : 0u) | \
+                                         (ENABLE_GESTURE_EXTENSION ? HOST_FEATURE_GESTURE_EXTENSION : 0u) | \
+                                         (ENABLE_ISR_LATENCY ? HOST_FEATURE_ISR_LATENCY : 0u) | \
+                                         (ENABLE_SLEEP_MANAGER ? HOST_FEATURE_SLEEP_MANAGER : 0u) | \
+                                         (ENABLE_FRAME_JITTER ? HOST_FEATURE_FRAME_JITTER : 0u) | \
+                                         (ENABLE_TOUCHPAD_PROCESSING_CHECK ? HOST_FEATURE_TOUCHPAD_CHECK : 0u))
+#endif
+
+/* Macros Related to the Tuner snapshot */
+#if (ENABLE_TUNER && ENABLE_TUNER_SNAPSHOT)
+/* Leading part of the Tuner data written by the host: the common context with the Tuner
+ * command and the widget parameters. The sensor data and positions that follow are outputs */
+#define TUNER_WRITABLE_SIZE             (offsetof(cy_stc_capsense_tuner_t, snsContext))
+#endif
+
+/* Macros Related to the idle-time task scheduler */
+#if ENABLE_IDLE_TASK_SCHEDULER
+#define IDLE_TASK_MAX_COUNT             (4u)
+
+/* Run period, deadline (maximum deferral in frames) and initial cost estimate in us */
+#define LED_TASK_PERIOD                 (1u)
+#define LED_TASK_DEADLINE               (4u)
+#define LED_TASK_COST                   (40u)
+
+#define TUNER_TASK_PERIOD               (1u)
+#define TUNER_TASK_DEADLINE             (2u)
+#define TUNER_TASK_COST                 (60u)
+#endif
+
 
 /* Macros Related to Gestures */
 #if (CY_CAPSENSE_GESTURE_EN)
@@ -131,6 +409,9 @@
 
 #define MAX_COUNTER_VALUE                                           (0xFFFFFFFF)
 
+/* On and off time of the LED blink indicating a flick */
+#define LED_BLINK_INTERVAL_IN_MILSEC                                (50u)
+
 /* Double click wait timeout before confirming single click detection */
 #define DOUBLE_CLICK_TIMEOUT                                        (CY_CAPSENSE_TOUCHPAD_CLICK_TIMEOUT_MAX_VALUE + CY_CAPSENSE_TOUCHPAD_SECOND_CLICK_INTERVAL_MIN_VALUE)
 
@@ -148,29 +429,399 @@ typedef enum
      * in this state with lowest refresh rate */
 } APPLICATION_STATE;
 
+#if ENABLE_POSITION_FILTER
+/*****************************************************************************
+ * Alpha-beta position tracker state
+ *****************************************************************************/
+typedef struct
+{
+    int32_t x;              /* Filtered position in 1/256 units */
+    int32_t y;
+    int32_t vx;             /* Filtered velocity in 1/256 units per frame */
+    int32_t vy;
+    uint16_t outX;          /* Extrapolated position reported to the consumers */
+    uint16_t outY;
+    uint8_t tracking;       /* Non-zero while the touch is tracked */
+} POSITION_FILTER;
+
+/*****************************************************************************
+ * Filtered position report, updated every processed frame. The raw position
+ * of the same frame lets the host compare both.
+ *****************************************************************************/
+typedef struct
+{
+    uint32_t sequence;                  /* Incremented before and after every update, odd while
+     * updating */
+    uint16_t x;                         /* Filtered and extrapolated position */
+    uint16_t y;
+    uint16_t rawX;                      /* Position reported by the middleware */
+    uint16_t rawY;
+    uint8_t touch;                      /* Non-zero while the touchpad is touched */
+} POSITION_REPORT;
+#endif
+
+#if ENABLE_TELEMETRY
+/*****************************************************************************
+ * Power state telemetry block, exposed to the host as is. The arrays are
+ * indexed by TELEMETRY_STATE_INDEX() of ACTIVE, ALR and WOT states.
+ *****************************************************************************/
+typedef struct
+{
+    uint32_t sequence;                  /* Incremented before and after every update, odd while
+     * updating. The host re-reads the block if it changes during the read */
+    uint32_t stateFrames[TELEMETRY_STATE_COUNT];    /* Frames scanned per state */
+    uint32_t transitions[TELEMETRY_STATE_COUNT][TELEMETRY_STATE_COUNT]; /* Transitions per
+     * [from][to] state edge */
+    uint64_t stateTime[TELEMETRY_STATE_COUNT];      /* Cumulative time in us per state */
+    uint64_t activeSessionStart;        /* ACTIVE state time when the current session started */
+    uint64_t longestActiveSession;      /* Longest completed ACTIVE session in us */
+    uint32_t wotTimeoutIloTicks;        /* ILO cycles of the last WOT frame ended by the timeout,
+     * which lasts WOT_MODE_FRAME_TIME. Scales the ILO time of the WOT frames ended by a touch.
+     * Zero without ENABLE_ILO_TIMEBASE */
+    uint32_t wotTimebaseWakeups;        /* CPU wake-ups in WOT mode by the ILO timebase interrupt */
+} TELEMETRY;
+#endif
+
+#if ENABLE_MULTI_TOUCH
+/*****************************************************************************
+ * Tracked touch contact. A contact keeps its slot and ID from touchdown to
+ * liftoff. The liftoff frame reports the last position with the LIFTOFF flag.
+ *****************************************************************************/
+typedef struct
+{
+    uint16_t x;                         /* Touch position */
+    uint16_t y;
+    uint16_t pressure;                  /* Touch signal (peak difference count) */
+    uint8_t id;                         /* Persistent touch ID, zero if the slot is free */
+    uint8_t flags;                      /* CONTACT_FLAG_TOUCHDOWN, CONTACT_FLAG_LIFTOFF */
+} TOUCH_CONTACT;
+
+/*****************************************************************************
+ * Multi-touch report, updated every processed frame
+ *****************************************************************************/
+typedef struct
+{
+    uint32_t sequence;                  /* Incremented before and after every update, odd while
+     * updating */
+    uint16_t maxProcessTime;            /* Worst-case tracking time per frame in us */
+    uint8_t numContacts;                /* Touches detected in the last frame */
+    uint8_t nextId;                     /* ID assigned to the next touchdown */
+    TOUCH_CONTACT contact[MULTI_TOUCH_MAX_CONTACTS];
+} TOUCH_REPORT;
+#endif
+
+#if ENABLE_GESTURE_EXTENSION
+/*****************************************************************************
+ * Gesture extension states
+ *****************************************************************************/
+typedef enum
+{
+    GESTURE_IDLE = 0x00u,       /* No touch and no momentum */
+    GESTURE_TRACKING = 0x01u,   /* Touch below the scroll start distance */
+    GESTURE_SCROLL = 0x02u,     /* One-finger scroll */
+    GESTURE_MOMENTUM = 0x03u,   /* Scroll continues with decaying speed after a fling */
+    GESTURE_DIAL = 0x04u        /* Circular movement around the touchpad center */
+} GESTURE_STATE;
+
+/*****************************************************************************
+ * Gesture extension report. The host reads the cumulative values and uses
+ * the change since its previous read, so no event is lost between reads.
+ *****************************************************************************/
+typedef struct
+{
+    uint32_t sequence;                  /* Incremented before and after every update, odd while
+     * updating */
+    int32_t scrollX;                    /* Cumulative scroll including momentum, in positions */
+    int32_t scrollY;
+    int32_t rotation;                   /* Cumulative dial rotation in 0.1 degrees, positive from
+     * the X axis towards the Y axis */
+    int16_t flingVelocityX;             /* Velocity of the last fling in positions per second */
+    int16_t flingVelocityY;
+    uint16_t flingCount;                /* Number of flings */
+    uint16_t maxProcessTime;            /* Worst-case processing time per frame in us */
+    uint8_t state;                      /* GESTURE_STATE */
+} GESTURE_REPORT;
+
+/*****************************************************************************
+ * Gesture extension state machine data
+ *****************************************************************************/
+typedef struct
+{
+    GESTURE_STATE state;
+    int32_t startX;                     /* Touchdown position */
+    int32_t startY;
+    int32_t lastX;                      /* Position in the previous frame */
+    int32_t lastY;
+    int32_t vx;                         /* Velocity in 1/256 positions per frame */
+    int32_t vy;
+    int32_t scrollX;                    /* Cumulative scroll in 1/256 positions */
+    int32_t scrollY;
+    int32_t rotation;                   /* Dial rotation not reported yet, in 1/ROTATION_SUBUNITS
+     * of 0.1 degrees */
+} GESTURE_ENGINE;
+#endif
+
+#if ENABLE_ISR_LATENCY
+/*****************************************************************************
+ * Time histogram with LATENCY_BUCKET_WIDTH us buckets
+ *****************************************************************************/
+typedef struct
+{
+    uint32_t count[LATENCY_HISTOGRAM_BUCKETS];
+    uint32_t max;                       /* Longest time in us */
+} LATENCY_HISTOGRAM;
+
+/*****************************************************************************
+ * Interrupt latency report. The histograms are updated from the interrupts,
+ * every counter is consistent but the histograms are not updated together.
+ * The wake-up times start when the CPU resumes in the main loop, the hardware
+ * event and the Deep Sleep wake-up before it are not timestamped.
+ *****************************************************************************/
+typedef struct
+{
+    LATENCY_HISTOGRAM capsenseWakeToIsr;    /* CPU wake-up to CAPSENSE ISR entry */
+    LATENCY_HISTOGRAM capsenseDuration;     /* CAPSENSE ISR execution */
+    LATENCY_HISTOGRAM ezi2cWakeToIsr;       /* CPU wake-up to EZI2C ISR entry */
+    LATENCY_HISTOGRAM ezi2cDuration;        /* EZI2C ISR execution */
+    LATENCY_HISTOGRAM deepSleepExitToResume; /* Deep Sleep exit callback to main loop resume */
+} LATENCY_REPORT;
+#endif
+
+#if ENABLE_FRAME_JITTER
+/*****************************************************************************
+ * Frame statistics of one host load bin. Processing time is measured from the
+ * end of the scan to the end of the frame, including the interrupts.
+ *****************************************************************************/
+typedef struct
+{
+    uint32_t frames;                    /* ACTIVE and ALR frames in this bin */
+    uint32_t deadlineMisses;            /* Frames exceeding the reserved processing time */
+    uint32_t touchMisses;               /* Deadline misses while a widget was active */
+    uint32_t totalProcessTime;          /* Sum of the processing time in us, wraps around */
+    uint32_t maxProcessTime;            /* Longest processing time in us */
+} JITTER_BIN;
+
+/*****************************************************************************
+ * Frame jitter report. The MSCLP wake up timer starts after the processing,
+ * so any processing time beyond the reserved one extends the frame period.
+ *****************************************************************************/
+typedef struct
+{
+    uint32_t sequence;                  /* Odd while the report is updated */
+    uint32_t snapshotSkips;             /* Tuner snapshots not published as the bus was busy or a host write was pending */
+    JITTER_BIN bin[JITTER_LOAD_BINS];   /* Indexed by the EZI2C interrupts in the frame / JITTER_LOAD_BIN_WIDTH */
+} JITTER_REPORT;
+#endif
+
+#if ENABLE_TOUCHPAD_SPECIALIZED_PROCESSING
+/*****************************************************************************
+ * Touchpad touch status and positions computed by the specialized processing
+ *****************************************************************************/
+typedef struct
+{
+    uint8_t active;                     /* Touch status after the debounce */
+    uint8_t numPosition;                /* Touches reported, zero while not active */
+    uint8_t debounce;                   /* Consecutive frames with a touch, up to the on debounce */
+    cy_stc_capsense_position_t position[CY_CAPSENSE_TOUCHPAD_NUM_TOUCHES];
+} TOUCHPAD_STATUS;
+#endif
+
+#if ENABLE_TOUCHPAD_PROCESSING_CHECK
+/*****************************************************************************
+ * Comparison of the specialized touchpad processing with the generic one.
+ * Cycles are CPU cycles of the touch status processing, including interrupts.
+ *****************************************************************************/
+typedef struct
+{
+    uint32_t sequence;                  /* Odd while the report is updated */
+    uint32_t frames;                    /* Frames processed by both */
+    uint32_t mismatches;                /* Frames with a different touch status, touch count or position */
+    uint32_t lastMismatchFrame;         /* Value of frames at the last mismatch */
+    uint32_t genericCycles;             /* Sum over the frames, wraps around */
+    uint32_t specializedCycles;         /* Sum over the frames, wraps around */
+    uint16_t maxGenericCycles;          /* Longest frame */
+    uint16_t maxSpecializedCycles;      /* Longest frame */
+} TOUCHPAD_CHECK_REPORT;
+#endif
+
+#if ENABLE_SLEEP_MANAGER
+/*****************************************************************************
+ * Sleep manager report. Times are the CPU time in us, measured when the
+ * SysTick is running.
+ *****************************************************************************/
+typedef struct
+{
+    uint32_t deepSleepCount;            /* Deep Sleep entries */
+    uint32_t deepSleepFailCount;        /* Deep Sleep entries rejected by a callback */
+    uint32_t sleepCount;                /* CPU Sleep entries used in place of Deep Sleep */
+    uint16_t transitionTime;            /* Average Deep Sleep entry and exit time */
+    uint16_t maxTransitionTime;         /* Longest Deep Sleep entry and exit time */
+    uint16_t ezi2cCallbackTime;         /* Longest EZI2C Deep Sleep callback execution */
+    uint16_t customCallbackTime;        /* Longest custom Deep Sleep callback execution */
+} SLEEP_REPORT;
+#endif
+
+#if ENABLE_HOST_INTERFACE
+/*****************************************************************************
+ * Host interface header. The host checks the version and the size before it
+ * reads the blocks, and finds the present blocks in the feature mask.
+ *****************************************************************************/
+typedef struct
+{
+    uint16_t version;                   /* HOST_INTERFACE_VERSION */
+    uint16_t size;                      /* Size of HOST_INTERFACE in bytes */
+    uint32_t features;                  /* HOST_FEATURE_* bits of the present blocks */
+} HOST_INTERFACE_HEADER;
+
+/*****************************************************************************
+ * Host interface, exposed on the EZI2C secondary slave address
+ *****************************************************************************/
+typedef struct
+{
+    HOST_INTERFACE_HEADER header;
+
+    #if ENABLE_TELEMETRY
+    TELEMETRY telemetry;
+    #endif
+
+    #if ENABLE_MULTI_TOUCH
+    TOUCH_REPORT touchReport;
+    #endif
+
+    #if ENABLE_POSITION_FILTER
+    POSITION_REPORT positionReport;
+    #endif
+
+    #if ENABLE_GESTURE_EXTENSION
+    GESTURE_REPORT gestureReport;
+    #endif
+
+    #if ENABLE_ISR_LATENCY
+    LATENCY_REPORT latencyReport;
+    #endif
+
+    #if ENABLE_SLEEP_MANAGER
+    SLEEP_REPORT sleepReport;
+    #endif
+
+    #if ENABLE_FRAME_JITTER
+    JITTER_REPORT jitterReport;
+    #endif
+
+    #if ENABLE_TOUCHPAD_PROCESSING_CHECK
+    TOUCHPAD_CHECK_REPORT touchpadCheck;
+    #endif
+} HOST_INTERFACE;
+#endif
+
+#if ENABLE_IDLE_TASK_SCHEDULER
+/*****************************************************************************
+ * Idle-time task descriptor
+ *****************************************************************************/
+typedef struct
+{
+    void (*task)(void);     /* Task function */
+    uint16_t period;        /* Run period in frames */
+    uint16_t deadline;      /* Frames the task can be deferred beyond its period */
+    uint16_t cost;          /* Estimated worst-case execution time in us */
+    uint16_t pending;       /* Frames elapsed since the task last ran */
+} IDLE_TASK;
+#endif
+
 /*******************************************************************************
 * Function Prototypes
 *******************************************************************************/
 static void initialize_capsense(void);
 static void capsense_msc0_isr(void);
 
+#if (ENABLE_TUNER || ENABLE_HOST_INTERFACE)
 static void ezi2c_isr(void);
 static void initialize_capsense_tuner(void);
+#endif
 
 #if (ENABLE_RUN_TIME_MEASUREMENT || CY_CAPSENSE_GESTURE_EN)
 static void init_sys_tick();
 #endif
 
+#if ENABLE_ILO_TIMEBASE
+static void init_ilo_timebase(void);
+static void wdt_isr(void);
+static uint32_t get_ilo_ticks(void);
+#endif
+
 #if ENABLE_RUN_TIME_MEASUREMENT
 static void start_runtime_measurement();
 static uint32_t stop_runtime_measurement();
 #endif
 
+#if (ENABLE_RUN_TIME_MEASUREMENT || CY_CAPSENSE_GESTURE_EN)
+static uint32_t get_elapsed_ticks(uint32_t start_tick);
+static uint32_t get_elapsed_time_us(uint32_t start_tick);
+#endif
+
+static uint32_t is_touch_active(void);
+
+#if ENABLE_TOUCHPAD_SPECIALIZED_PROCESSING
+static void process_touchpad(void);
+static void update_touchpad_status(TOUCHPAD_STATUS *ptrStatus);
+#endif
+
+#if ENABLE_TOUCHPAD_PROCESSING_CHECK
+static void update_touchpad_check(uint32_t generic_cycles, uint32_t specialized_cycles);
+#endif
+
+#if ENABLE_IDLE_TASK_SCHEDULER
+#if (ENABLE_TUNER || ENABLE_PWM_LED)
+static void register_idle_task(void (*task)(void), uint16_t period, uint16_t deadline, uint16_t cost);
+#endif
+static void run_idle_tasks(uint32_t budget, uint32_t process_time);
+#endif
+
+#if ENABLE_TUNER
+static void tuner_task(void);
+#endif
+
+#if ENABLE_TELEMETRY
+static void update_telemetry(void);
+#endif
+
+#if ENABLE_MULTI_TOUCH
+static void update_multi_touch(void);
+static uint8_t next_contact_id(volatile TOUCH_REPORT *ptrReport);
+#endif
+
+#if ENABLE_GESTURE_EXTENSION
+static void update_gesture_extension(void);
+#endif
+
+#if ENABLE_ISR_LATENCY
+static void record_cpu_wakeup(void);
+static void add_to_histogram(volatile LATENCY_HISTOGRAM *ptrHistogram, uint32_t time);
+#endif
+
+#if ENABLE_FRAME_JITTER
+static void update_frame_jitter(void);
+#endif
+
+#if ENABLE_POSITION_FILTER
+static void update_position_filter(void);
+static uint16_t extrapolate_position(int32_t position, int32_t velocity);
+#endif
+
+#if (ENABLE_TUNER && ENABLE_TUNER_SNAPSHOT)
+static void publish_tuner_snapshot(void);
+#endif
+
+#if (ENABLE_TUNER && (ENABLE_TUNER_SNAPSHOT || ENABLE_IDLE_TASK_SCHEDULER))
+static void tuner_receive_callback(uint8_t **commandPacket, uint8_t **tunerPacket, void *context);
+#endif
+
 void led_control();
 void PWM_initialisation(void);
 
 #if (CY_CAPSENSE_GESTURE_EN)
 void double_click_timeout(void);
+void advance_gesture_timers(uint32_t elapsed_ms);
 
 void SysTickCallback(void);
 #endif
@@ -180,6 +831,19 @@ void register_callback(void);
 cy_en_syspm_status_t deep_sleep_callback(cy_stc_syspm_callback_params_t *callbackParams,
         cy_en_syspm_callback_mode_t mode);
 
+#if ENABLE_SLEEP_MANAGER
+static void enter_cpu_low_power(uint32_t idle_window);
+#if ENABLE_ILO_TIMEBASE
+static void update_ilo_estimate(uint32_t idle_window);
+#endif
+static uint32_t us_to_ilo_ticks(uint32_t time_us);
+#if (ENABLE_PWM_LED && ENABLE_ACTIVE_DEEP_SLEEP)
+static uint32_t is_led_on(void);
+#endif
+cy_en_syspm_status_t ezi2c_deep_sleep_callback(cy_stc_syspm_callback_params_t *callbackParams,
+        cy_en_syspm_callback_mode_t mode);
+#endif
+
 /*******************************************************************************
  * Global Definitions
  *******************************************************************************/
@@ -196,8 +860,92 @@ uint8_t startDoubleClickTimer;
 APPLICATION_STATE capsense_state;
 APPLICATION_STATE prev_capsense_state;
 
+#if ENABLE_POSITION_FILTER
+/* Touch position tracker, updated every processed frame */
+POSITION_FILTER position_filter;
+#endif
+
+#if ENABLE_HOST_INTERFACE
+/* Data exposed to the host on the EZI2C secondary slave address */
+volatile HOST_INTERFACE host_interface;
+#endif
+
+#if ENABLE_GESTURE_EXTENSION
+/* Scroll, momentum and dial gesture state */
+GESTURE_ENGINE gesture_engine;
+#endif
+
+#if ENABLE_ISR_LATENCY
+/* SysTick values at the CPU wake-up in the main loop and at the Deep Sleep exit */
+uint32_t cpu_wakeup_tick;
+uint32_t deep_sleep_exit_tick;
+
+/* Set at the CPU wake-up if the interrupt is pending, cleared by the first run of the ISR after the wake-up */
+volatile uint8_t capsense_wakeup_pending;
+volatile uint8_t ezi2c_wakeup_pending;
+volatile uint8_t deep_sleep_exit_pending;
+#endif
+
+#if ENABLE_TOUCHPAD_SPECIALIZED_PROCESSING
+/* Touchpad status of the specialized processing, kept between the frames for the hysteresis and the debounce */
+TOUCHPAD_STATUS touchpad_status;
+#endif
+
+#if ENABLE_FRAME_JITTER
+/* EZI2C interrupts since the end of the previous frame */
+volatile uint32_t ezi2c_isr_count;
+#endif
+
+#if ENABLE_ILO_TIMEBASE
+/* WDT counter wraps, the upper bits of the ILO timebase */
+volatile uint32_t ilo_timebase_wraps;
+#endif
+
+#if ENABLE_ILO_TIMEBASE
+/* ILO timebase at the start of the scan of the frame */
+uint32_t scan_start_ilo_ticks;
+#endif
+
+#if (ENABLE_TELEMETRY && ENABLE_ILO_TIMEBASE)
+/* ILO timebase at the end of the WOT frame */
+uint32_t wot_end_ilo_ticks;
+#endif
+
+#if ENABLE_SLEEP_MANAGER
+/* ILO cycles per ms in 1/256 units, measured on the ACTIVE and ALR frames with the ILO timebase */
+uint32_t ilo_ticks_per_ms = ILO_TICKS_PER_MS_NOMINAL;
+
+#if (CY_CAPSENSE_GESTURE_EN && ENABLE_ILO_TIMEBASE)
+/* ILO cycles spent in Deep Sleep not yet added to the gesture timestamp */
+uint32_t gesture_deep_sleep_ticks;
+#endif
+#endif
+
+#if ENABLE_IDLE_TASK_SCHEDULER
+/* Registered idle-time tasks, run in the registration order */
+IDLE_TASK idle_tasks[IDLE_TASK_MAX_COUNT];
+uint8_t idle_task_count;
+
+/* Set by a task that waited for the host, its run is not a cost sample */
+uint8_t idle_task_blocked;
+#endif
+
+#if (ENABLE_RUN_TIME_MEASUREMENT || CY_CAPSENSE_GESTURE_EN)
+/* SysTick value captured when the frame processing starts */
+uint32_t frame_start_tick;
+#endif
+
 cy_stc_scb_ezi2c_context_t ezi2c_context;
 
+#if (ENABLE_TUNER && ENABLE_TUNER_SNAPSHOT)
+/* Tuner data snapshots. The front one is exposed over EZI2C, the back one is filled with the next frame */
+cy_stc_capsense_tuner_t tuner_snapshot[2];
+uint32_t tuner_front;
+
+/* Host writes to the front snapshot completed, each copied to the live data by the EZI2C interrupt */
+volatile uint32_t tuner_write_count;
+#endif
+
 /* Callback parameters for custom, EzI2C */
 
 /* Callback parameters for EzI2C */
@@ -216,7 +964,11 @@ cy_stc_syspm_callback_params_t deepSleepCallBackParams = {
 /* Callback declaration for EzI2C Deep Sleep callback */
 cy_stc_syspm_callback_t ezi2cCallback =
 {
+        #if ENABLE_SLEEP_MANAGER
+        .callback       = &ezi2c_deep_sleep_callback,
+        #else
         .callback       = (Cy_SysPmCallback)&Cy_SCB_EZI2C_DeepSleepCallback,
+        #endif
         .type           = CY_SYSPM_DEEPSLEEP,
         .skipMode       = 0UL,
         .callbackParams = &ezi2cCallbackParams,
@@ -230,7 +982,7 @@ cy_stc_syspm_callback_t deepSleepCb =
 {
         .callback       = &deep_sleep_callback,
         .type           = CY_SYSPM_DEEPSLEEP,
-        .skipMode       = 0UL,
+        .skipMode       = DEEP_SLEEP_CB_SKIP_MODE,
         .callbackParams = &deepSleepCallBackParams,
         .prevItm        = NULL,
         .nextItm        = NULL,
@@ -279,7 +1031,7 @@ int main(void)
     /* Enable global interrupts */
     __enable_irq();
 
-    #if ENABLE_TUNER
+    #if (ENABLE_TUNER || ENABLE_HOST_INTERFACE)
     /* Initialize EZI2C */
     initialize_capsense_tuner();
     #endif
@@ -288,12 +1040,28 @@ int main(void)
     PWM_initialisation();
     #endif
 
+    #if ENABLE_ILO_TIMEBASE
+    /* Start the WDT counter used to time the Deep Sleep periods */
+    init_ilo_timebase();
+    #endif
+
     /* Register callbacks */
     register_callback();
 
-    /* Define initial state of the device and the corresponding refresh rate*/
-    capsense_state = ACTIVE_MODE;
-    capsense_state_timeout = ACTIVE_MODE_TIMEOUT;
+    #if ENABLE_IDLE_TASK_SCHEDULER
+    /* Register the housekeeping tasks run in the idle time of every frame */
+    #if ENABLE_TUNER
+    register_idle_task(tuner_task, TUNER_TASK_PERIOD, TUNER_TASK_DEADLINE, TUNER_TASK_COST);
+    #endif
+
+    #if ENABLE_PWM_LED
+    register_idle_task(led_control, LED_TASK_PERIOD, LED_TASK_DEADLINE, LED_TASK_COST);
+    #endif
+    #endif
+
+    /* Define initial state of the device and the corresponding refresh rate*/
+    capsense_state = ACTIVE_MODE;
+    capsense_state_timeout = ACTIVE_MODE_TIMEOUT;
 
     /* Initialize MSCLP CAPSENSE */
     initialize_capsense();
@@ -306,36 +1074,69 @@ int main(void)
 
     for (;;)
     {
+        /* State of the frame scanned in this iteration */
+        prev_capsense_state = capsense_state;
+
         switch(capsense_state)
         {
             case ACTIVE_MODE:
 
+                #if ENABLE_ILO_TIMEBASE
+                scan_start_ilo_ticks = get_ilo_ticks();
+                #endif
+
                 Cy_CapSense_ScanAllSlots(&cy_capsense_context);
 
                 interruptStatus = Cy_SysLib_EnterCriticalSection();
 
                 while (Cy_CapSense_IsBusy(&cy_capsense_context))
                 {
-                    #if ENABLE_PWM_LED
+                    #if ENABLE_SLEEP_MANAGER
+                    enter_cpu_low_power(ACTIVE_MODE_IDLE_WINDOW);
+                    #elif ENABLE_PWM_LED
                     Cy_SysPm_CpuEnterSleep();
                     #else
                     Cy_SysPm_CpuEnterDeepSleep();
                     #endif
 
+                    #if ENABLE_ISR_LATENCY
+                    record_cpu_wakeup();
+                    #endif
+
                     Cy_SysLib_ExitCriticalSection(interruptStatus);
 
                     /* This is a place where all interrupt handlers will be executed */
                     interruptStatus = Cy_SysLib_EnterCriticalSection();
                 }
 
+                #if (ENABLE_SLEEP_MANAGER && ENABLE_ILO_TIMEBASE)
+                update_ilo_estimate(ACTIVE_MODE_IDLE_WINDOW);
+                #endif
+
                 #if ENABLE_RUN_TIME_MEASUREMENT
                 active_processing_time=0;
                 start_runtime_measurement();
                 #endif
 
+                #if (ENABLE_RUN_TIME_MEASUREMENT || CY_CAPSENSE_GESTURE_EN)
+                frame_start_tick = Cy_SysTick_GetValue();
+                #endif
+
                 Cy_SysLib_ExitCriticalSection(interruptStatus);
 
+                #if ENABLE_TOUCHPAD_SPECIALIZED_PROCESSING
+                process_touchpad();
+                #else
                 Cy_CapSense_ProcessAllWidgets(&cy_capsense_context);
+                #endif
+
+                #if ENABLE_POSITION_FILTER
+                update_position_filter();
+                #endif
+
+                #if ENABLE_MULTI_TOUCH
+                update_multi_touch();
+                #endif
 
                 #if (CY_CAPSENSE_GESTURE_EN)
                 /*decode all the gestures*/
@@ -345,8 +1146,12 @@ int main(void)
                 double_click_timeout();
                 #endif
 
+                #if ENABLE_GESTURE_EXTENSION
+                update_gesture_extension();
+                #endif
+
                 /* Scan, process and check the status of the all Active mode sensors */
-                if(Cy_CapSense_IsAnyWidgetActive(&cy_capsense_context))
+                if(is_touch_active())
                 {
                     capsense_state_timeout = ACTIVE_MODE_TIMEOUT;
                 }
@@ -374,12 +1179,24 @@ int main(void)
                 /* Active Low Refresh-rate Mode */
             case ALR_MODE :
 
+                #if ENABLE_ILO_TIMEBASE
+                scan_start_ilo_ticks = get_ilo_ticks();
+                #endif
+
                 Cy_CapSense_ScanAllSlots(&cy_capsense_context);
                 interruptStatus = Cy_SysLib_EnterCriticalSection();
 
                 while (Cy_CapSense_IsBusy(&cy_capsense_context))
                 {
+                    #if ENABLE_SLEEP_MANAGER
+                    enter_cpu_low_power(ALR_MODE_IDLE_WINDOW);
+                    #else
                     Cy_SysPm_CpuEnterDeepSleep();
+                    #endif
+
+                    #if ENABLE_ISR_LATENCY
+                    record_cpu_wakeup();
+                    #endif
 
                     Cy_SysLib_ExitCriticalSection(interruptStatus);
 
@@ -387,6 +1204,10 @@ int main(void)
                     interruptStatus = Cy_SysLib_EnterCriticalSection();
                 }
 
+                #if (ENABLE_SLEEP_MANAGER && ENABLE_ILO_TIMEBASE)
+                update_ilo_estimate(ALR_MODE_IDLE_WINDOW);
+                #endif
+
                 Cy_SysLib_ExitCriticalSection(interruptStatus);
 
                 #if ENABLE_RUN_TIME_MEASUREMENT
@@ -394,10 +1215,26 @@ int main(void)
                 start_runtime_measurement();
                 #endif
 
+                #if (ENABLE_RUN_TIME_MEASUREMENT || CY_CAPSENSE_GESTURE_EN)
+                frame_start_tick = Cy_SysTick_GetValue();
+                #endif
+
+                #if ENABLE_TOUCHPAD_SPECIALIZED_PROCESSING
+                process_touchpad();
+                #else
                 Cy_CapSense_ProcessAllWidgets(&cy_capsense_context);
+                #endif
+
+                #if ENABLE_POSITION_FILTER
+                update_position_filter();
+                #endif
+
+                #if ENABLE_MULTI_TOUCH
+                update_multi_touch();
+                #endif
 
                 /* Scan, process and check the status of the all Active mode sensors */
-                if(Cy_CapSense_IsAnyWidgetActive(&cy_capsense_context))
+                if(is_touch_active())
                 {
                     capsense_state = ACTIVE_MODE;
                     capsense_state_timeout = ACTIVE_MODE_TIMEOUT;
@@ -430,13 +1267,25 @@ int main(void)
                 /* Wake On Touch Mode */
             case WOT_MODE :
 
+                #if ENABLE_ILO_TIMEBASE
+                scan_start_ilo_ticks = get_ilo_ticks();
+                #endif
+
                 Cy_CapSense_ScanAllLpSlots(&cy_capsense_context);
 
                 interruptStatus = Cy_SysLib_EnterCriticalSection();
 
                 while (Cy_CapSense_IsBusy(&cy_capsense_context))
                 {
+                    #if ENABLE_SLEEP_MANAGER
+                    enter_cpu_low_power(WOT_MODE_IDLE_WINDOW);
+                    #else
                     Cy_SysPm_CpuEnterDeepSleep();
+                    #endif
+
+                    #if ENABLE_ISR_LATENCY
+                    record_cpu_wakeup();
+                    #endif
 
                     Cy_SysLib_ExitCriticalSection(interruptStatus);
 
@@ -446,6 +1295,14 @@ int main(void)
 
                 Cy_SysLib_ExitCriticalSection(interruptStatus);
 
+                #if (ENABLE_TELEMETRY && ENABLE_ILO_TIMEBASE)
+                wot_end_ilo_ticks = get_ilo_ticks();
+                #endif
+
+                #if (ENABLE_RUN_TIME_MEASUREMENT || CY_CAPSENSE_GESTURE_EN)
+                frame_start_tick = Cy_SysTick_GetValue();
+                #endif
+
                 if (Cy_CapSense_IsAnyLpWidgetActive(&cy_capsense_context))
                 {
                     capsense_state = ACTIVE_MODE;
@@ -476,13 +1333,39 @@ int main(void)
                 break;
         }
 
+        #if ENABLE_IDLE_TASK_SCHEDULER
+        /* Run the housekeeping tasks that fit in the time left in the frame just processed */
+        switch(prev_capsense_state)
+        {
+            case ACTIVE_MODE:
+                run_idle_tasks(ACTIVE_MODE_FRAME_PROCESS_TIME, ACTIVE_MODE_PROCESS_TIME);
+                break;
+
+            case ALR_MODE:
+                run_idle_tasks(ALR_MODE_FRAME_PROCESS_TIME, ALR_MODE_PROCESS_TIME);
+                break;
+
+            default:
+                /* The WOT frame has no processing time reserved, its touch check is negligible */
+                run_idle_tasks(ALR_MODE_TASK_BUDGET, 0u);
+                break;
+        }
+        #else
         #if ENABLE_PWM_LED
         led_control();
         #endif
 
         #if ENABLE_TUNER
-        /* Establishes synchronized communication with the CAPSENSE Tuner tool */
-        Cy_CapSense_RunTuner(&cy_capsense_context);
+        tuner_task();
+        #endif
+        #endif
+
+        #if ENABLE_FRAME_JITTER
+        update_frame_jitter();
+        #endif
+
+        #if ENABLE_TELEMETRY
+        update_telemetry();
         #endif
     }
 }
@@ -500,6 +1383,9 @@ int main(void)
 static void initialize_capsense(void)
 {
     cy_capsense_status_t status = CY_CAPSENSE_STATUS_SUCCESS;
+    #if ENABLE_TOUCHPAD_SPECIALIZED_PROCESSING
+    const cy_stc_capsense_widget_config_t *ptrTouchpadCfg;
+    #endif
 
     /* CAPSENSE interrupt configuration MSCLP 0 */
     const cy_stc_sysint_t capsense_msc0_interrupt_config =
@@ -520,6 +1406,25 @@ static void initialize_capsense(void)
 
         /* Initialize the CAPSENSE firmware modules. */
         status = Cy_CapSense_Enable(&cy_capsense_context);
+
+        #if ENABLE_TOUCHPAD_SPECIALIZED_PROCESSING
+        /* The specialized touchpad processing is built for the touchpad set in the CAPSENSE Configurator: its
+         * geometry and resolution, the 3 x 3 centroid without ballistic multiplier and no position filter. The
+         * edge correction is not checked, the middleware applies it to CSD touchpads only */
+        ptrTouchpadCfg = &cy_capsense_context.ptrWdConfig[CY_CAPSENSE_TOUCHPAD_WDGT_ID];
+        CY_ASSERT((TOUCHPAD_NUM_COLS == ptrTouchpadCfg->numCols) && (TOUCHPAD_NUM_ROWS == ptrTouchpadCfg->numRows) &&
+                  (TOUCHPAD_MAX_POSITION == ptrTouchpadCfg->xResolution) &&
+                  (TOUCHPAD_MAX_POSITION == ptrTouchpadCfg->yResolution) &&
+                  (CY_CAPSENSE_CENTROID_3X3_MASK == (ptrTouchpadCfg->centroidConfig &
+                                                     (CY_CAPSENSE_CENTROID_3X3_MASK | CY_CAPSENSE_CENTROID_5X5_MASK |
+                                                      CY_CAPSENSE_CENTROID_BALLISTIC_MASK))) &&
+                  (0u == (ptrTouchpadCfg->posFilterConfig & CY_CAPSENSE_POSITION_FILTERS_MASK)));
+        #endif
+
+        #if (ENABLE_TUNER && (ENABLE_TUNER_SNAPSHOT || ENABLE_IDLE_TASK_SCHEDULER))
+        /* Cy_CapSense_Init() clears the callbacks, so the Tuner receive callback is registered after it */
+        cy_capsense_context.ptrInternalContext->ptrTunerReceiveCallback = tuner_receive_callback;
+        #endif
     }
 
     if(status != CY_CAPSENSE_STATUS_SUCCESS)
@@ -539,9 +1444,24 @@ static void initialize_capsense(void)
 *******************************************************************************/
 static void capsense_msc0_isr(void)
 {
+    #if ENABLE_ISR_LATENCY
+    uint32_t entry_tick = Cy_SysTick_GetValue();
+
+    if (0u != capsense_wakeup_pending)
+    {
+        capsense_wakeup_pending = 0u;
+        add_to_histogram(&host_interface.latencyReport.capsenseWakeToIsr, get_elapsed_time_us(cpu_wakeup_tick));
+    }
+    #endif
+
     Cy_CapSense_InterruptHandler(CY_MSCLP0_HW, &cy_capsense_context);
+
+    #if ENABLE_ISR_LATENCY
+    add_to_histogram(&host_interface.latencyReport.capsenseDuration, get_elapsed_time_us(entry_tick));
+    #endif
 }
 
+#if (ENABLE_TUNER || ENABLE_HOST_INTERFACE)
 /*******************************************************************************
 * Function Name: initialize_capsense_tuner
 ********************************************************************************
@@ -577,75 +1497,1476 @@ static void initialize_capsense_tuner(void)
      * connect only one tool at a time.
      */
 
-    #if ENABLE_TUNER
-    Cy_SCB_EZI2C_SetBuffer1(CYBSP_EZI2C_HW, (uint8_t *)&cy_capsense_tuner,
-                            sizeof(cy_capsense_tuner), sizeof(cy_capsense_tuner),
-                            &ezi2c_context);
-    #endif
+    #if (ENABLE_TUNER && ENABLE_TUNER_SNAPSHOT)
+    /* The host reads the published snapshot instead of the live CAPSENSE data */
+    tuner_snapshot[0u] = cy_capsense_tuner;
+    tuner_snapshot[1u] = cy_capsense_tuner;
+    tuner_front = 0u;
+
+    Cy_SCB_EZI2C_SetBuffer1(CYBSP_EZI2C_HW, (uint8_t *)&tuner_snapshot[tuner_front],
+                            sizeof(cy_capsense_tuner), sizeof(cy_capsense_tuner),
+                            &ezi2c_context);
+    #elif ENABLE_TUNER
+    Cy_SCB_EZI2C_SetBuffer1(CYBSP_EZI2C_HW, (uint8_t *)&cy_capsense_tuner,
+                            sizeof(cy_capsense_tuner), sizeof(cy_capsense_tuner),
+                            &ezi2c_context);
+    #endif
+
+    #if ENABLE_HOST_INTERFACE
+    host_interface.header.version = HOST_INTERFACE_VERSION;
+    host_interface.header.size = (uint16_t)sizeof(host_interface);
+    host_interface.header.features = HOST_INTERFACE_FEATURES;
+
+    /* Expose the read-only host interface on the secondary slave address */
+    Cy_SCB_EZI2C_SetBuffer2(CYBSP_EZI2C_HW, (uint8_t *)&host_interface,
+                            sizeof(host_interface), 0u, &ezi2c_context);
+    #endif
+
+    Cy_SCB_EZI2C_Enable(CYBSP_EZI2C_HW);
+}
+
+/*******************************************************************************
+* Function Name: ezi2c_isr
+********************************************************************************
+* Summary:
+* Wrapper function for handling interrupts from EZI2C block.
+*
+* With the Tuner snapshot, the bytes of a completed host write are copied from
+* the front snapshot to the live CAPSENSE data, as the driver writes them to the
+* live data without the snapshot. A partially written parameter never reaches
+* the live data, and a rewrite of the value read is applied like any other.
+* The written range is the sub-address of the write up to the position after its
+* last byte, both kept in the driver context.
+*
+*******************************************************************************/
+static void ezi2c_isr(void)
+{
+    #if (ENABLE_TUNER && ENABLE_TUNER_SNAPSHOT)
+    uint32_t first;
+    uint32_t last;
+    #endif
+
+    #if ENABLE_ISR_LATENCY
+    uint32_t entry_tick = Cy_SysTick_GetValue();
+
+    if (0u != ezi2c_wakeup_pending)
+    {
+        ezi2c_wakeup_pending = 0u;
+        add_to_histogram(&host_interface.latencyReport.ezi2cWakeToIsr, get_elapsed_time_us(cpu_wakeup_tick));
+    }
+    #endif
+
+    #if ENABLE_FRAME_JITTER
+    ezi2c_isr_count++;
+    #endif
+
+    Cy_SCB_EZI2C_Interrupt(CYBSP_EZI2C_HW, &ezi2c_context);
+
+    #if (ENABLE_TUNER && ENABLE_TUNER_SNAPSHOT)
+    if (0u != (Cy_SCB_EZI2C_GetActivity(CYBSP_EZI2C_HW, &ezi2c_context) & CY_SCB_EZI2C_STATUS_WRITE1))
+    {
+        /* Only the writable part is copied, the sensor data and positions that follow are outputs */
+        first = ezi2c_context.baseAddr1;
+        last = CY_MIN((uint32_t)(ezi2c_context.curBuf - ezi2c_context.buf1), TUNER_WRITABLE_SIZE);
+
+        if (first < last)
+        {
+            memcpy((uint8_t *)&cy_capsense_tuner + first, (uint8_t *)&tuner_snapshot[tuner_front] + first,
+                   last - first);
+        }
+        tuner_write_count++;
+    }
+    #endif
+
+    #if ENABLE_ISR_LATENCY
+    add_to_histogram(&host_interface.latencyReport.ezi2cDuration, get_elapsed_time_us(entry_tick));
+    #endif
+}
+#endif
+
+#if (ENABLE_TUNER && ENABLE_TUNER_SNAPSHOT)
+/*******************************************************************************
+* Function Name: publish_tuner_snapshot
+********************************************************************************
+* Summary:
+*  Copies the live CAPSENSE data to the back snapshot and exposes it to the host
+*  in place of the front one. The copy is made with the interrupts enabled, as
+*  the back snapshot is not exposed; only the buffer swap is made in a critical
+*  section. The buffers are swapped when no EZI2C transaction is in progress, so
+*  the host never reads a partially updated frame, and when no host write
+*  completed during the copy, so the new snapshot holds all the written values.
+*  Otherwise the publication is skipped and the host keeps reading the previous
+*  complete frame until the next call.
+*
+*******************************************************************************/
+static void publish_tuner_snapshot(void)
+{
+    uint32_t interruptStatus;
+    uint32_t back = tuner_front ^ 1u;
+    uint32_t writeCount = tuner_write_count;
+
+    tuner_snapshot[back] = cy_capsense_tuner;
+
+    interruptStatus = Cy_SysLib_EnterCriticalSection();
+
+    if ((0u == (Cy_SCB_EZI2C_GetActivity(CYBSP_EZI2C_HW, &ezi2c_context) & CY_SCB_EZI2C_STATUS_BUSY)) &&
+        (writeCount == tuner_write_count))
+    {
+        Cy_SCB_EZI2C_SetBuffer1(CYBSP_EZI2C_HW, (uint8_t *)&tuner_snapshot[back],
+                                sizeof(cy_capsense_tuner), sizeof(cy_capsense_tuner),
+                                &ezi2c_context);
+        tuner_front = back;
+    }
+    #if ENABLE_FRAME_JITTER
+    else
+    {
+        host_interface.jitterReport.snapshotSkips++;
+    }
+    #endif
+
+    Cy_SysLib_ExitCriticalSection(interruptStatus);
+}
+#endif
+
+#if (ENABLE_TUNER && (ENABLE_TUNER_SNAPSHOT || ENABLE_IDLE_TASK_SCHEDULER))
+/*******************************************************************************
+* Function Name: tuner_receive_callback
+********************************************************************************
+* Summary:
+*  Called by Cy_CapSense_RunTuner() before every Tuner command check, also in
+*  the loop that waits for the resume command while the Tuner suspends the
+*  scanning. Copies the common context with the command acknowledgement and the
+*  Tuner state to the front snapshot, as no snapshot is published while
+*  suspended, unless a host write to the snapshot is in progress. The commands
+*  are read from the live data, so no command packet is returned.
+*  A call in the suspended state marks the Tuner task as blocked, so the time
+*  spent waiting for the host is not taken as its execution time.
+*
+* Parameters:
+*  commandPacket - Command packet received, always NULL
+*  tunerPacket - Tuner packet to send, always NULL
+*  context - CAPSENSE context, not used
+*
+*******************************************************************************/
+static void tuner_receive_callback(uint8_t **commandPacket, uint8_t **tunerPacket, void *context)
+{
+    #if ENABLE_TUNER_SNAPSHOT
+    uint32_t interruptStatus;
+    #endif
+
+    (void)context;
+
+    *commandPacket = NULL;
+    *tunerPacket = NULL;
+
+    #if ENABLE_IDLE_TASK_SCHEDULER
+    if (CY_CAPSENSE_TU_FSM_SUSPENDED == cy_capsense_context.ptrCommonContext->tunerSt)
+    {
+        idle_task_blocked = 1u;
+    }
+    #endif
+
+    #if ENABLE_TUNER_SNAPSHOT
+    interruptStatus = Cy_SysLib_EnterCriticalSection();
+
+    if (0u == (Cy_SCB_EZI2C_GetActivity(CYBSP_EZI2C_HW, &ezi2c_context) & CY_SCB_EZI2C_STATUS_BUSY))
+    {
+        tuner_snapshot[tuner_front].commonContext = cy_capsense_tuner.commonContext;
+    }
+
+    Cy_SysLib_ExitCriticalSection(interruptStatus);
+    #endif
+}
+#endif
+
+#if (ENABLE_RUN_TIME_MEASUREMENT || CY_CAPSENSE_GESTURE_EN)
+/*******************************************************************************
+ * Function Name: init_sys_tick
+ ********************************************************************************
+ * Summary:
+ *  initializes the system tick with highest possible value to start counting down.
+ *
+ *******************************************************************************/
+static void init_sys_tick()
+{
+    Cy_SysTick_Init (CY_SYSTICK_CLOCK_SOURCE_CLK_CPU ,SYS_TICK_INTERVAL );
+    cy_capsense_context.ptrCommonContext->timestampInterval = TIMESTAMP_INTERVAL_IN_MILSEC;
+    #if (CY_CAPSENSE_GESTURE_EN)
+    Cy_SysTick_SetCallback(0u,SysTickCallback);
+    #endif
+}
+#endif
+
+#if ENABLE_ILO_TIMEBASE
+/*******************************************************************************
+ * Function Name: init_ilo_timebase
+ ********************************************************************************
+ * Summary:
+ *  Starts the WDT counter with an interrupt on every wrap of the counter. The
+ *  interrupt wakes the CPU from Deep Sleep every 2^16 ILO cycles, about 1.6 s.
+ *
+ *******************************************************************************/
+static void init_ilo_timebase(void)
+{
+    /* WDT interrupt configuration structure */
+    const cy_stc_sysint_t wdt_intr_config =
+    {
+        .intrSrc = srss_interrupt_wdt_IRQn,
+        .intrPriority = WDT_INTR_PRIORITY,
+    };
+
+    Cy_SysInt_Init(&wdt_intr_config, wdt_isr);
+    NVIC_ClearPendingIRQ(wdt_intr_config.intrSrc);
+    NVIC_EnableIRQ(wdt_intr_config.intrSrc);
+
+    /* Match when the counter wraps to zero */
+    Cy_WDT_SetMatch(0u);
+    Cy_WDT_ClearInterrupt();
+    Cy_WDT_UnmaskInterrupt();
+    Cy_WDT_Enable();
+}
+
+/*******************************************************************************
+ * Function Name: wdt_isr
+ ********************************************************************************
+ * Summary:
+ *  Counts the WDT counter wraps. Clearing the interrupt also keeps the WDT
+ *  from resetting the device. The wake-ups in WOT mode are counted in the
+ *  telemetry, they are the power cost of the timebase.
+ *
+ *******************************************************************************/
+static void wdt_isr(void)
+{
+    Cy_WDT_ClearInterrupt();
+    ilo_timebase_wraps++;
+
+    #if ENABLE_TELEMETRY
+    if (WOT_MODE == capsense_state)
+    {
+        host_interface.telemetry.wotTimebaseWakeups++;
+    }
+    #endif
+}
+
+/*******************************************************************************
+ * Function Name: get_ilo_ticks
+ ********************************************************************************
+ * Summary:
+ *  Returns the ILO cycles counted since init_ilo_timebase(). Intervals are
+ *  measured by the difference of two values, also across Deep Sleep.
+ *
+ *******************************************************************************/
+static uint32_t get_ilo_ticks(void)
+{
+    uint32_t interruptStatus;
+    uint32_t wraps;
+    uint32_t count;
+
+    interruptStatus = Cy_SysLib_EnterCriticalSection();
+
+    wraps = ilo_timebase_wraps;
+    count = Cy_WDT_GetCount();
+
+    /* A wrap not counted yet. The count is read again, as it may have been read before the wrap */
+    if (0u != NVIC_GetPendingIRQ(srss_interrupt_wdt_IRQn))
+    {
+        wraps++;
+        count = Cy_WDT_GetCount();
+    }
+
+    Cy_SysLib_ExitCriticalSection(interruptStatus);
+
+    return (wraps << WDT_COUNTER_BITS) + count;
+}
+#endif
+
+#if ENABLE_RUN_TIME_MEASUREMENT
+/*******************************************************************************
+ * Function Name: start_runtime_measurement
+ ********************************************************************************
+ * Summary:
+ *  Initializes the system tick counter by calling Cy_SysTick_Clear() API.
+ *******************************************************************************/
+static void start_runtime_measurement()
+{
+    Cy_SysTick_Clear();
+}
+
+/*******************************************************************************
+ * Function Name: stop_runtime_measurement
+ ********************************************************************************
+ * Summary:
+ *  Reads the system tick and converts to time in microseconds(us).
+ *
+ *  Returns:
+ *  runtime - in microseconds(us)
+ *******************************************************************************/
+
+static uint32_t stop_runtime_measurement()
+{
+    uint32_t ticks;
+    uint32_t runtime;
+    ticks=Cy_SysTick_GetValue();
+    ticks= SYS_TICK_INTERVAL - Cy_SysTick_GetValue();
+    runtime=ticks*TIME_PER_TICK_IN_US;
+    return runtime;
+}
+#endif
+
+#if (ENABLE_RUN_TIME_MEASUREMENT || CY_CAPSENSE_GESTURE_EN)
+/*******************************************************************************
+ * Function Name: get_elapsed_time_us
+ ********************************************************************************
+ * Summary:
+ *  Returns the time elapsed since the given SysTick value. The SysTick reload
+ *  is handled, so intervals up to one SysTick period can be measured.
+ *
+ * Parameters:
+ *  start_tick: SysTick value captured at the start of the interval
+ *
+ * Return:
+ *  Elapsed time in microseconds(us)
+ *******************************************************************************/
+static uint32_t get_elapsed_time_us(uint32_t start_tick)
+{
+    return (get_elapsed_ticks(start_tick) / SYS_TICK_PER_US);
+}
+
+/*******************************************************************************
+ * Function Name: get_elapsed_ticks
+ ********************************************************************************
+ * Summary:
+ *  Returns the SysTick cycles, i.e. the CPU cycles, elapsed since the given
+ *  SysTick value.
+ *
+ * Parameters:
+ *  start_tick: SysTick value captured at the start of the interval
+ *
+ *******************************************************************************/
+static uint32_t get_elapsed_ticks(uint32_t start_tick)
+{
+    uint32_t current_tick = Cy_SysTick_GetValue();
+
+    /* SysTick counts down and reloads with SYS_TICK_INTERVAL */
+    if (start_tick >= current_tick)
+    {
+        return (start_tick - current_tick);
+    }
+
+    return (start_tick + ((uint32_t)SYS_TICK_INTERVAL - current_tick));
+}
+#endif
+
+#if ENABLE_IDLE_TASK_SCHEDULER
+#if (ENABLE_TUNER || ENABLE_PWM_LED)
+/*******************************************************************************
+ * Function Name: register_idle_task
+ ********************************************************************************
+ * Summary:
+ *  Adds a task to the idle-time scheduler. Tasks are run in the registration
+ *  order, so the tasks registered first have the highest priority.
+ *
+ * Parameters:
+ *  task: Task function
+ *  period: Run period in frames
+ *  deadline: Frames the task can be deferred beyond its period before it runs
+ *            whether it fits in the frame or not
+ *  cost: Initial estimate of the task execution time in us
+ *
+ *******************************************************************************/
+static void register_idle_task(void (*task)(void), uint16_t period, uint16_t deadline, uint16_t cost)
+{
+    if (idle_task_count < IDLE_TASK_MAX_COUNT)
+    {
+        idle_tasks[idle_task_count].task = task;
+        idle_tasks[idle_task_count].period = period;
+        idle_tasks[idle_task_count].deadline = deadline;
+        idle_tasks[idle_task_count].cost = cost;
+        idle_tasks[idle_task_count].pending = 0u;
+        idle_task_count++;
+    }
+    else
+    {
+        CY_ASSERT(CY_ASSERT_FAILED);
+    }
+}
+#endif
+
+/*******************************************************************************
+ * Function Name: run_idle_tasks
+ ********************************************************************************
+ * Summary:
+ *  Runs the tasks overdue by their deadline, then the other due tasks whose
+ *  estimated cost fits in the time left in the frame, each group in the
+ *  registration order. A due task that does not fit is deferred to a later
+ *  frame, at most until its deadline, when it runs even if the frame overruns.
+ *  Deferred runs are coalesced, i.e. the task runs once however many periods
+ *  were skipped.
+ *
+ *  The budget is enforced on the cost estimates. When the SysTick is running,
+ *  the estimate follows a longer measured execution time at once and decays
+ *  slowly after shorter ones. A run in which the task waited for the host,
+ *  such as the Tuner suspending the scanning, is not a cost sample.
+ *
+ * Parameters:
+ *  budget: Frame processing time in us, available for the processing and tasks
+ *  process_time: Processing time in us assumed when it is not measured
+ *
+ *******************************************************************************/
+static void run_idle_tasks(uint32_t budget, uint32_t process_time)
+{
+    uint32_t remaining;
+    uint32_t cost;
+    uint32_t overdue;
+    uint32_t pass;
+    uint32_t i;
+    IDLE_TASK *ptrTask;
+
+    #if (ENABLE_RUN_TIME_MEASUREMENT || CY_CAPSENSE_GESTURE_EN)
+    uint32_t task_start_tick;
+    uint32_t elapsed = get_elapsed_time_us(frame_start_tick);
+
+    remaining = (budget > elapsed) ? (budget - elapsed) : 0u;
+    #else
+    /* Processing time is not measured, assume it took the whole time reserved for it */
+    remaining = (budget > process_time) ? (budget - process_time) : 0u;
+    #endif
+
+    for (i = 0u; i < idle_task_count; i++)
+    {
+        if (idle_tasks[i].pending < UINT16_MAX)
+        {
+            idle_tasks[i].pending++;
+        }
+    }
+
+    /* Pass 0 runs the overdue tasks, pass 1 the other due tasks */
+    for (pass = 0u; pass < 2u; pass++)
+    {
+        for (i = 0u; i < idle_task_count; i++)
+        {
+            ptrTask = &idle_tasks[i];
+            overdue = (ptrTask->pending >= (ptrTask->period + ptrTask->deadline)) ? 1u : 0u;
+
+            if ((ptrTask->pending < ptrTask->period) || (overdue == pass))
+            {
+                continue;
+            }
+
+            if ((0u == overdue) && (ptrTask->cost > remaining))
+            {
+                continue;
+            }
+
+            #if (ENABLE_RUN_TIME_MEASUREMENT || CY_CAPSENSE_GESTURE_EN)
+            idle_task_blocked = 0u;
+            task_start_tick = Cy_SysTick_GetValue();
+            ptrTask->task();
+            cost = CY_MIN(get_elapsed_time_us(task_start_tick), UINT16_MAX);
+
+            if (0u != idle_task_blocked)
+            {
+                /* The frame is over, keep the estimate */
+                cost = remaining;
+            }
+            /* Follow a longer execution at once, decay by 1/8 of the difference otherwise */
+            else if (cost > ptrTask->cost)
+            {
+                ptrTask->cost = (uint16_t)cost;
+            }
+            else
+            {
+                ptrTask->cost = (uint16_t)(((7u * (uint32_t)ptrTask->cost) + cost) >> 3u);
+            }
+            #else
+            ptrTask->task();
+            cost = ptrTask->cost;
+            #endif
+
+            remaining = (remaining > cost) ? (remaining - cost) : 0u;
+            ptrTask->pending = 0u;
+        }
+    }
+}
+#endif
+
+#if ENABLE_POSITION_FILTER
+/*******************************************************************************
+ * Function Name: update_position_filter
+ ********************************************************************************
+ * Summary:
+ *  Updates the alpha-beta tracker with the touchpad position of the processed
+ *  frame. The tracker predicts the position from the previous frame, corrects
+ *  the prediction with ALPHA and the velocity with BETA parts of the error, and
+ *  reports the position extrapolated by POSITION_FILTER_LEAD. The tracker
+ *  restarts at the reported position on every touchdown. The filtered and the
+ *  raw positions are published in the position report.
+ *
+ *******************************************************************************/
+static void update_position_filter(void)
+{
+    volatile POSITION_REPORT *ptrReport = &host_interface.positionReport;
+    cy_stc_capsense_touch_t *panelTouch;
+    int32_t errorX;
+    int32_t errorY;
+
+    if (SENSOR_ACTIVE != Cy_CapSense_IsWidgetActive(CY_CAPSENSE_TOUCHPAD_WDGT_ID, &cy_capsense_context))
+    {
+        position_filter.tracking = 0u;
+
+        if (0u != ptrReport->touch)
+        {
+            ptrReport->sequence++;
+            ptrReport->touch = 0u;
+            ptrReport->sequence++;
+        }
+        return;
+    }
+
+    panelTouch = Cy_CapSense_GetTouchInfo(CY_CAPSENSE_TOUCHPAD_WDGT_ID, &cy_capsense_context);
+
+    if (0u == position_filter.tracking)
+    {
+        position_filter.x = (int32_t)panelTouch->ptrPosition->x << 8u;
+        position_filter.y = (int32_t)panelTouch->ptrPosition->y << 8u;
+        position_filter.vx = 0;
+        position_filter.vy = 0;
+        position_filter.tracking = 1u;
+    }
+    else
+    {
+        /* Predict, then correct with the measured position */
+        position_filter.x += position_filter.vx;
+        position_filter.y += position_filter.vy;
+
+        errorX = ((int32_t)panelTouch->ptrPosition->x << 8u) - position_filter.x;
+        errorY = ((int32_t)panelTouch->ptrPosition->y << 8u) - position_filter.y;
+
+        position_filter.x += (errorX * (int32_t)POSITION_FILTER_ALPHA) / 256;
+        position_filter.y += (errorY * (int32_t)POSITION_FILTER_ALPHA) / 256;
+        position_filter.vx += (errorX * (int32_t)POSITION_FILTER_BETA) / 256;
+        position_filter.vy += (errorY * (int32_t)POSITION_FILTER_BETA) / 256;
+    }
+
+    position_filter.outX = extrapolate_position(position_filter.x, position_filter.vx);
+    position_filter.outY = extrapolate_position(position_filter.y, position_filter.vy);
+
+    ptrReport->sequence++;
+    ptrReport->x = position_filter.outX;
+    ptrReport->y = position_filter.outY;
+    ptrReport->rawX = panelTouch->ptrPosition->x;
+    ptrReport->rawY = panelTouch->ptrPosition->y;
+    ptrReport->touch = 1u;
+    ptrReport->sequence++;
+}
+
+/*******************************************************************************
+ * Function Name: extrapolate_position
+ ********************************************************************************
+ * Summary:
+ *  Extrapolates the filtered position by POSITION_FILTER_LEAD and limits it to
+ *  the touchpad range.
+ *
+ * Parameters:
+ *  position: Filtered position in 1/256 units
+ *  velocity: Filtered velocity in 1/256 units per frame
+ *
+ * Return:
+ *  Extrapolated position
+ *******************************************************************************/
+static uint16_t extrapolate_position(int32_t position, int32_t velocity)
+{
+    int32_t result = (position + ((velocity * (int32_t)POSITION_FILTER_LEAD) / 256) + 128) / 256;
+
+    if (result < 0)
+    {
+        result = 0;
+    }
+    else if (result > (int32_t)TOUCHPAD_MAX_POSITION)
+    {
+        result = (int32_t)TOUCHPAD_MAX_POSITION;
+    }
+
+    return (uint16_t)result;
+}
+#endif
+
+#if ENABLE_MULTI_TOUCH
+/*******************************************************************************
+ * Function Name: update_multi_touch
+ ********************************************************************************
+ * Summary:
+ *  Assigns the touchpad touches of the processed frame to the tracked contacts.
+ *  The closest touch and contact pairs are matched first, a touch farther than
+ *  MULTI_TOUCH_MAX_DISTANCE from every contact starts a new contact. With two
+ *  contacts at most, the matching takes a fixed number of steps per frame.
+ *
+ *******************************************************************************/
+static void update_multi_touch(void)
+{
+    volatile TOUCH_REPORT *ptrReport = &host_interface.touchReport;
+    volatile TOUCH_CONTACT *ptrContact;
+    cy_stc_capsense_touch_t *panelTouch;
+    cy_stc_capsense_position_t *ptrPosition;
+    uint8_t contactOfTouch[MULTI_TOUCH_MAX_CONTACTS];
+    uint8_t touchOfContact[MULTI_TOUCH_MAX_CONTACTS];
+    uint32_t numTouches = 0u;
+    uint32_t bestDistance;
+    uint32_t distance;
+    uint32_t bestTouch;
+    uint32_t bestContact;
+    uint32_t touch;
+    uint32_t i;
+    int32_t dx;
+    int32_t dy;
+
+    #if (ENABLE_RUN_TIME_MEASUREMENT || CY_CAPSENSE_GESTURE_EN)
+    uint32_t start_tick = Cy_SysTick_GetValue();
+    uint32_t process_time;
+    #endif
+
+    if (SENSOR_ACTIVE == Cy_CapSense_IsWidgetActive(CY_CAPSENSE_TOUCHPAD_WDGT_ID, &cy_capsense_context))
+    {
+        panelTouch = Cy_CapSense_GetTouchInfo(CY_CAPSENSE_TOUCHPAD_WDGT_ID, &cy_capsense_context);
+        numTouches = CY_MIN((uint32_t)panelTouch->numPosition, MULTI_TOUCH_MAX_CONTACTS);
+        ptrPosition = panelTouch->ptrPosition;
+    }
+
+    ptrReport->sequence++;
+
+    /* Free the slots lifted off in the previous frame */
+    for (i = 0u; i < MULTI_TOUCH_MAX_CONTACTS; i++)
+    {
+        ptrContact = &ptrReport->contact[i];
+
+        if (0u != (ptrContact->flags & CONTACT_FLAG_LIFTOFF))
+        {
+            ptrContact->id = 0u;
+        }
+        ptrContact->flags = 0u;
+        contactOfTouch[i] = MULTI_TOUCH_NO_MATCH;
+        touchOfContact[i] = MULTI_TOUCH_NO_MATCH;
+    }
+
+    /* Match the closest touch and contact pairs */
+    do
+    {
+        bestDistance = (uint32_t)MULTI_TOUCH_MAX_DISTANCE * MULTI_TOUCH_MAX_DISTANCE + 1u;
+        bestTouch = MULTI_TOUCH_NO_MATCH;
+        bestContact = MULTI_TOUCH_NO_MATCH;
+
+        for (touch = 0u; touch < numTouches; touch++)
+        {
+            for (i = 0u; i < MULTI_TOUCH_MAX_CONTACTS; i++)
+            {
+                ptrContact = &ptrReport->contact[i];
+
+                if ((MULTI_TOUCH_NO_MATCH == contactOfTouch[touch]) &&
+                    (MULTI_TOUCH_NO_MATCH == touchOfContact[i]) && (0u != ptrContact->id))
+                {
+                    dx = (int32_t)ptrPosition[touch].x - (int32_t)ptrContact->x;
+                    dy = (int32_t)ptrPosition[touch].y - (int32_t)ptrContact->y;
+                    distance = (uint32_t)((dx * dx) + (dy * dy));
+
+                    if (distance < bestDistance)
+                    {
+                        bestDistance = distance;
+                        bestTouch = touch;
+                        bestContact = i;
+                    }
+                }
+            }
+        }
+
+        if (MULTI_TOUCH_NO_MATCH != bestTouch)
+        {
+            contactOfTouch[bestTouch] = (uint8_t)bestContact;
+            touchOfContact[bestContact] = (uint8_t)bestTouch;
+        }
+    } while (MULTI_TOUCH_NO_MATCH != bestTouch);
+
+    /* Contacts without a touch lift off */
+    for (i = 0u; i < MULTI_TOUCH_MAX_CONTACTS; i++)
+    {
+        if ((0u != ptrReport->contact[i].id) && (MULTI_TOUCH_NO_MATCH == touchOfContact[i]))
+        {
+            ptrReport->contact[i].flags = CONTACT_FLAG_LIFTOFF;
+        }
+    }
+
+    /* Touches without a contact take a free slot and a new ID */
+    for (touch = 0u; touch < numTouches; touch++)
+    {
+        for (i = 0u; (MULTI_TOUCH_NO_MATCH == contactOfTouch[touch]) && (i < MULTI_TOUCH_MAX_CONTACTS); i++)
+        {
+            if (0u == ptrReport->contact[i].id)
+            {
+                ptrReport->contact[i].id = next_contact_id(ptrReport);
+                ptrReport->contact[i].flags = CONTACT_FLAG_TOUCHDOWN;
+                contactOfTouch[touch] = (uint8_t)i;
+            }
+        }
+
+        if (MULTI_TOUCH_NO_MATCH != contactOfTouch[touch])
+        {
+            ptrContact = &ptrReport->contact[contactOfTouch[touch]];
+            ptrContact->x = ptrPosition[touch].x;
+            ptrContact->y = ptrPosition[touch].y;
+            ptrContact->pressure = ptrPosition[touch].z;
+        }
+    }
+
+    ptrReport->numContacts = (uint8_t)numTouches;
+
+    #if (ENABLE_RUN_TIME_MEASUREMENT || CY_CAPSENSE_GESTURE_EN)
+    process_time = get_elapsed_time_us(start_tick);
+
+    if (process_time > ptrReport->maxProcessTime)
+    {
+        ptrReport->maxProcessTime = (uint16_t)CY_MIN(process_time, UINT16_MAX);
+    }
+    #endif
+
+    ptrReport->sequence++;
+}
+
+/*******************************************************************************
+ * Function Name: next_contact_id
+ ********************************************************************************
+ * Summary:
+ *  Returns the ID of a new contact and advances nextId. The IDs wrap after 255
+ *  touchdowns and skip zero and the IDs of the contacts in the report, so a
+ *  finger held over the wrap keeps an ID no other contact gets.
+ *
+ * Parameters:
+ *  ptrReport: Multi-touch report
+ *
+ * Return:
+ *  Contact ID
+ *
+ *******************************************************************************/
+static uint8_t next_contact_id(volatile TOUCH_REPORT *ptrReport)
+{
+    uint8_t id = ptrReport->nextId;
+    uint32_t inUse;
+    uint32_t i;
+
+    do
+    {
+        id = (0u == (uint8_t)(id + 1u)) ? 1u : (uint8_t)(id + 1u);
+        inUse = 0u;
+
+        for (i = 0u; i < MULTI_TOUCH_MAX_CONTACTS; i++)
+        {
+            if (id == ptrReport->contact[i].id)
+            {
+                inUse = 1u;
+            }
+        }
+    } while (0u != inUse);
+
+    ptrReport->nextId = id;
+
+    return id;
+}
+#endif
+
+#if ENABLE_GESTURE_EXTENSION
+/*******************************************************************************
+ * Function Name: update_gesture_extension
+ ********************************************************************************
+ * Summary:
+ *  Runs one step of the scroll, momentum and dial gesture state machine with
+ *  the single touch position of the frame. Uses fixed memory and a constant
+ *  number of operations per frame.
+ *
+ *  A touchdown farther than DIAL_MIN_RADIUS from the touchpad center starts the
+ *  dial gesture, the rotation is accumulated from the angle between the
+ *  positions of consecutive frames. Other touches scroll after moving by
+ *  SCROLL_START_DISTANCE. A scroll lifted off faster than FLING_MIN_SPEED is a
+ *  fling and continues as momentum scroll, slowed down by FLING_DECAY every
+ *  frame until a touchdown or FLING_STOP_SPEED. Two-finger touches are left to
+ *  the CAPSENSE gestures.
+ *
+ *******************************************************************************/
+static void update_gesture_extension(void)
+{
+    volatile GESTURE_REPORT *ptrReport = &host_interface.gestureReport;
+    GESTURE_ENGINE *ptrEngine = &gesture_engine;
+    cy_stc_capsense_touch_t *panelTouch;
+    uint32_t touched = 0u;
+    int32_t x = 0;
+    int32_t y = 0;
+    int32_t dx;
+    int32_t dy;
+    int32_t cross;
+    int32_t dot;
+    int32_t angle;
+
+    #if (ENABLE_RUN_TIME_MEASUREMENT || CY_CAPSENSE_GESTURE_EN)
+    uint32_t start_tick = Cy_SysTick_GetValue();
+    uint32_t process_time;
+    #endif
+
+    if (SENSOR_ACTIVE == Cy_CapSense_IsWidgetActive(CY_CAPSENSE_TOUCHPAD_WDGT_ID, &cy_capsense_context))
+    {
+        panelTouch = Cy_CapSense_GetTouchInfo(CY_CAPSENSE_TOUCHPAD_WDGT_ID, &cy_capsense_context);
+
+        if (1u == panelTouch->numPosition)
+        {
+            touched = 1u;
+            x = (int32_t)panelTouch->ptrPosition->x;
+            y = (int32_t)panelTouch->ptrPosition->y;
+        }
+        else
+        {
+            /* Multi-finger touch cancels the one-finger gestures */
+            ptrEngine->state = GESTURE_IDLE;
+        }
+    }
+
+    ptrReport->sequence++;
+
+    dx = x - ptrEngine->lastX;
+    dy = y - ptrEngine->lastY;
+
+    switch(ptrEngine->state)
+    {
+        case GESTURE_IDLE:
+        case GESTURE_MOMENTUM:
+            if (0u != touched)
+            {
+                ptrEngine->startX = x;
+                ptrEngine->startY = y;
+                ptrEngine->vx = 0;
+                ptrEngine->vy = 0;
+
+                dx = x - TOUCHPAD_CENTER;
+                dy = y - TOUCHPAD_CENTER;
+
+                if (((dx * dx) + (dy * dy)) >= (int32_t)(DIAL_MIN_RADIUS * DIAL_MIN_RADIUS))
+                {
+                    ptrEngine->rotation = 0;
+                    ptrEngine->state = GESTURE_DIAL;
+                }
+                else
+                {
+                    ptrEngine->state = GESTURE_TRACKING;
+                }
+            }
+            else if (GESTURE_MOMENTUM == ptrEngine->state)
+            {
+                ptrEngine->scrollX += ptrEngine->vx;
+                ptrEngine->scrollY += ptrEngine->vy;
+                ptrEngine->vx = (ptrEngine->vx * (int32_t)FLING_DECAY) / 256;
+                ptrEngine->vy = (ptrEngine->vy * (int32_t)FLING_DECAY) / 256;
+
+                if (((ptrEngine->vx * ptrEngine->vx) + (ptrEngine->vy * ptrEngine->vy)) <
+                    (FLING_STOP_VELOCITY * FLING_STOP_VELOCITY))
+                {
+                    ptrEngine->state = GESTURE_IDLE;
+                }
+            }
+            else
+            {
+                /* No touch and no momentum */
+            }
+            break;
+
+        case GESTURE_TRACKING:
+        case GESTURE_SCROLL:
+            if (0u == touched)
+            {
+                if ((GESTURE_SCROLL == ptrEngine->state) &&
+                    (((ptrEngine->vx * ptrEngine->vx) + (ptrEngine->vy * ptrEngine->vy)) >=
+                     (FLING_MIN_VELOCITY * FLING_MIN_VELOCITY)))
+                {
+                    ptrReport->flingVelocityX = (int16_t)((ptrEngine->vx * (int32_t)ACTIVE_MODE_REFRESH_RATE) / 256);
+                    ptrReport->flingVelocityY = (int16_t)((ptrEngine->vy * (int32_t)ACTIVE_MODE_REFRESH_RATE) / 256);
+                    ptrReport->flingCount++;
+                    ptrEngine->state = GESTURE_MOMENTUM;
+                }
+                else
+                {
+                    ptrEngine->state = GESTURE_IDLE;
+                }
+                break;
+            }
+
+            ptrEngine->vx += (((dx * 256) - ptrEngine->vx) * GESTURE_VELOCITY_WEIGHT) / 256;
+            ptrEngine->vy += (((dy * 256) - ptrEngine->vy) * GESTURE_VELOCITY_WEIGHT) / 256;
+
+            if (GESTURE_SCROLL == ptrEngine->state)
+            {
+                ptrEngine->scrollX += dx * 256;
+                ptrEngine->scrollY += dy * 256;
+            }
+            else
+            {
+                dx = x - ptrEngine->startX;
+                dy = y - ptrEngine->startY;
+
+                if (((dx * dx) + (dy * dy)) >= (int32_t)(SCROLL_START_DISTANCE * SCROLL_START_DISTANCE))
+                {
+                    /* Scroll by the whole movement since touchdown */
+                    ptrEngine->scrollX += dx * 256;
+                    ptrEngine->scrollY += dy * 256;
+                    ptrEngine->state = GESTURE_SCROLL;
+                }
+            }
+            break;
+
+        case GESTURE_DIAL:
+            if (0u == touched)
+            {
+                ptrEngine->state = GESTURE_IDLE;
+                break;
+            }
+
+            /* Angle between the center-relative positions: atan(cross / dot), which is
+             * cross / dot for the small movement in one frame */
+            cross = ((ptrEngine->lastX - TOUCHPAD_CENTER) * (y - TOUCHPAD_CENTER)) -
+                    ((ptrEngine->lastY - TOUCHPAD_CENTER) * (x - TOUCHPAD_CENTER));
+            dot = ((ptrEngine->lastX - TOUCHPAD_CENTER) * (x - TOUCHPAD_CENTER)) +
+                  ((ptrEngine->lastY - TOUCHPAD_CENTER) * (y - TOUCHPAD_CENTER));
+
+            /* Movements of 90 degrees or more in one frame are not tracked. The angle is
+             * rounded to ROTATION_SUBUNITS and the part below 0.1 degree is carried to the
+             * next frame, so slow rotations are not lost to the truncation */
+            if (dot > 0)
+            {
+                angle = cross * (RADIAN_TO_DECIDEGREE * ROTATION_SUBUNITS);
+                angle = (angle + ((angle >= 0) ? (dot / 2) : -(dot / 2))) / dot;
+
+                ptrEngine->rotation += angle;
+                ptrReport->rotation += ptrEngine->rotation / ROTATION_SUBUNITS;
+                ptrEngine->rotation %= ROTATION_SUBUNITS;
+            }
+            break;
+
+        default:
+            ptrEngine->state = GESTURE_IDLE;
+            break;
+    }
+
+    ptrEngine->lastX = x;
+    ptrEngine->lastY = y;
+
+    ptrReport->scrollX = ptrEngine->scrollX / 256;
+    ptrReport->scrollY = ptrEngine->scrollY / 256;
+    ptrReport->state = (uint8_t)ptrEngine->state;
+
+    #if (ENABLE_RUN_TIME_MEASUREMENT || CY_CAPSENSE_GESTURE_EN)
+    process_time = get_elapsed_time_us(start_tick);
+
+    if (process_time > ptrReport->maxProcessTime)
+    {
+        ptrReport->maxProcessTime = (uint16_t)CY_MIN(process_time, UINT16_MAX);
+    }
+    #endif
+
+    ptrReport->sequence++;
+}
+#endif
+
+/*******************************************************************************
+ * Function Name: is_touch_active
+ ********************************************************************************
+ * Summary:
+ *  Returns non-zero if a widget processed in the ACTIVE and ALR frames is
+ *  active. With the specialized touchpad processing only the touchpad is
+ *  processed; the low power widget keeps the status of the last WOT frame, so
+ *  it is not checked.
+ *
+ *******************************************************************************/
+static uint32_t is_touch_active(void)
+{
+    #if ENABLE_TOUCHPAD_SPECIALIZED_PROCESSING
+    return Cy_CapSense_IsWidgetActive(CY_CAPSENSE_TOUCHPAD_WDGT_ID, &cy_capsense_context);
+    #else
+    return Cy_CapSense_IsAnyWidgetActive(&cy_capsense_context);
+    #endif
+}
+
+#if ENABLE_TOUCHPAD_SPECIALIZED_PROCESSING
+/*******************************************************************************
+ * Function Name: process_touchpad
+ ********************************************************************************
+ * Summary:
+ *  Processes the touchpad, the single widget scanned in the ACTIVE and ALR
+ *  frames. The middleware filters the raw counts and updates the baseline and
+ *  the difference counts; the touch status and the positions are computed by
+ *  update_touchpad_status() and written to the widget data read by the
+ *  gestures, the Tuner and the host.
+ *
+ *  With ENABLE_TOUCHPAD_PROCESSING_CHECK the generic status processing of the
+ *  middleware runs as well and its results are used; the specialized results
+ *  are only compared with them.
+ *
+ *******************************************************************************/
+static void process_touchpad(void)
+{
+    #if ENABLE_TOUCHPAD_PROCESSING_CHECK
+    uint32_t start_tick;
+    uint32_t generic_cycles;
+    uint32_t specialized_cycles;
+    #else
+    cy_stc_capsense_widget_context_t *ptrWdCxt =
+            cy_capsense_context.ptrWdConfig[CY_CAPSENSE_TOUCHPAD_WDGT_ID].ptrWdContext;
+    #endif
+
+    Cy_CapSense_ProcessWidgetExt(CY_CAPSENSE_TOUCHPAD_WDGT_ID, TOUCHPAD_RAW_COUNT_STAGES, &cy_capsense_context);
+
+    #if ENABLE_TOUCHPAD_PROCESSING_CHECK
+    start_tick = Cy_SysTick_GetValue();
+    Cy_CapSense_ProcessWidgetExt(CY_CAPSENSE_TOUCHPAD_WDGT_ID, CY_CAPSENSE_PROCESS_STATUS, &cy_capsense_context);
+    generic_cycles = get_elapsed_ticks(start_tick);
+
+    start_tick = Cy_SysTick_GetValue();
+    update_touchpad_status(&touchpad_status);
+    specialized_cycles = get_elapsed_ticks(start_tick);
+
+    update_touchpad_check(generic_cycles, specialized_cycles);
+    #else
+    update_touchpad_status(&touchpad_status);
+
+    ptrWdCxt->status = (uint8_t)((ptrWdCxt->status & (uint8_t)~CY_CAPSENSE_WD_ACTIVE_MASK) | touchpad_status.active);
+    ptrWdCxt->wdTouch.numPosition = touchpad_status.numPosition;
+    memcpy(ptrWdCxt->wdTouch.ptrPosition, touchpad_status.position,
+           touchpad_status.numPosition * sizeof(cy_stc_capsense_position_t));
+    #endif
+}
+
+/*******************************************************************************
+ * Function Name: update_touchpad_status
+ ********************************************************************************
+ * Summary:
+ *  Touch status and centroid processing specialized for the 4 x 5 CSX touchpad.
+ *  It follows the generic CSX touchpad processing with the configuration of
+ *  this example, where the position filters and the ballistic multiplier are
+ *  disabled:
+ *  - A touch is a local maximum of the difference counts at or above the
+ *    finger threshold, plus the hysteresis while not active and minus it while
+ *    active. A node must exceed the neighbours before it in the sensor order
+ *    and not be lower than the ones after it, so equal nodes give one touch.
+ *  - The strongest touches are kept, the first in the sensor order on a tie.
+ *  - The position is the 3 x 3 centroid around the maximum, nodes outside the
+ *    touchpad count as zero. z is the sum of the 3 x 3 nodes, and the touch ID
+ *    is its rank.
+ *  - The touchpad is active after touches in on debounce consecutive frames,
+ *    and inactive in the first frame without touch.
+ *  The loop bounds and the position scaling are constants; the thresholds are
+ *  read from the widget data, as the Tuner and the host can change them.
+ *  The rules are validated against the middleware on the device with
+ *  ENABLE_TOUCHPAD_PROCESSING_CHECK, or offline against captured middleware
+ *  results with test/test_touchpad_processing.
+ *
+ *  The sensors are ordered column by column, the node at column col and row
+ *  row is the sensor col * TOUCHPAD_NUM_ROWS + row.
+ *
+ * Parameters:
+ *  ptrStatus: Status of the previous frame, updated with this frame
+ *
+ *******************************************************************************/
+static void update_touchpad_status(TOUCHPAD_STATUS *ptrStatus)
+{
+    const cy_stc_capsense_widget_config_t *ptrWdCfg = &cy_capsense_context.ptrWdConfig[CY_CAPSENSE_TOUCHPAD_WDGT_ID];
+    const cy_stc_capsense_widget_context_t *ptrWdCxt = ptrWdCfg->ptrWdContext;
+    const cy_stc_capsense_sensor_context_t *ptrSnsCxt = ptrWdCfg->ptrSnsContext;
+
+    /* Difference counts with a border of zeros, so the neighbours need no bounds check */
+    uint16_t diff[TOUCHPAD_NUM_COLS + 2u][TOUCHPAD_NUM_ROWS + 2u];
+    uint16_t peak[CY_CAPSENSE_TOUCHPAD_NUM_TOUCHES];
+    uint8_t peakCol[CY_CAPSENSE_TOUCHPAD_NUM_TOUCHES];
+    uint8_t peakRow[CY_CAPSENSE_TOUCHPAD_NUM_TOUCHES];
+    cy_stc_capsense_position_t *ptrPosition;
+    uint32_t threshold;
+    uint32_t count = 0u;
+    uint32_t col;
+    uint32_t row;
+    uint32_t i;
+    uint32_t d;
+    uint32_t sum;
+    int32_t x;
+    int32_t y;
+
+    memset(diff, 0, sizeof(diff));
+    for (col = 0u; col < TOUCHPAD_NUM_COLS; col++)
+    {
+        for (row = 0u; row < TOUCHPAD_NUM_ROWS; row++)
+        {
+            diff[col + 1u][row + 1u] = ptrSnsCxt[(col * TOUCHPAD_NUM_ROWS) + row].diff;
+        }
+    }
+
+    if (0u != ptrStatus->active)
+    {
+        threshold = (ptrWdCxt->fingerTh > ptrWdCxt->hysteresis) ?
+                    ((uint32_t)ptrWdCxt->fingerTh - ptrWdCxt->hysteresis) : 0u;
+    }
+    else
+    {
+        threshold = (uint32_t)ptrWdCxt->fingerTh + ptrWdCxt->hysteresis;
+    }
+
+    for (col = 1u; col <= TOUCHPAD_NUM_COLS; col++)
+    {
+        for (row = 1u; row <= TOUCHPAD_NUM_ROWS; row++)
+        {
+            d = diff[col][row];
+
+            if ((d < threshold) ||
+                (d <= diff[col - 1u][row - 1u]) || (d <= diff[col - 1u][row]) || (d <= diff[col - 1u][row + 1u]) ||
+                (d <= diff[col][row - 1u]) || (d < diff[col][row + 1u]) ||
+                (d < diff[col + 1u][row - 1u]) || (d < diff[col + 1u][row]) || (d < diff[col + 1u][row + 1u]))
+            {
+                continue;
+            }
+
+            /* Insert in the touches sorted by decreasing difference count */
+            i = CY_MIN(count, CY_CAPSENSE_TOUCHPAD_NUM_TOUCHES);
+            while ((i > 0u) && (d > peak[i - 1u]))
+            {
+                if (i < CY_CAPSENSE_TOUCHPAD_NUM_TOUCHES)
+                {
+                    peak[i] = peak[i - 1u];
+                    peakCol[i] = peakCol[i - 1u];
+                    peakRow[i] = peakRow[i - 1u];
+                }
+                i--;
+            }
+            if (i < CY_CAPSENSE_TOUCHPAD_NUM_TOUCHES)
+            {
+                peak[i] = (uint16_t)d;
+                peakCol[i] = (uint8_t)col;
+                peakRow[i] = (uint8_t)row;
+                count = CY_MIN(count + 1u, CY_CAPSENSE_TOUCHPAD_NUM_TOUCHES);
+            }
+        }
+    }
+
+    if (0u == count)
+    {
+        ptrStatus->debounce = 0u;
+        ptrStatus->active = 0u;
+    }
+    else
+    {
+        if (ptrStatus->debounce < ptrWdCxt->onDebounce)
+        {
+            ptrStatus->debounce++;
+        }
+        if (ptrStatus->debounce >= ptrWdCxt->onDebounce)
+        {
+            ptrStatus->active = 1u;
+        }
+    }
+
+    ptrStatus->numPosition = (0u != ptrStatus->active) ? (uint8_t)count : 0u;
+
+    for (i = 0u; i < ptrStatus->numPosition; i++)
+    {
+        col = peakCol[i];
+        row = peakRow[i];
+        sum = 0u;
+        x = 0;
+        y = 0;
+
+        for (d = 0u; d < 3u; d++)
+        {
+            sum += (uint32_t)diff[col - 1u][row - 1u + d] + diff[col][row - 1u + d] + diff[col + 1u][row - 1u + d];
+            x += (int32_t)diff[col + 1u][row - 1u + d] - (int32_t)diff[col - 1u][row - 1u + d];
+            y += (int32_t)diff[col - 1u + d][row + 1u] - (int32_t)diff[col - 1u + d][row - 1u];
+        }
+
+        /* Centroid in 1/256 node pitches from the first node, limited to the touchpad */
+        x = (int32_t)((col - 1u) << 8u) + ((x * 256) / (int32_t)sum);
+        y = (int32_t)((row - 1u) << 8u) + ((y * 256) / (int32_t)sum);
+        x = CY_MIN(CY_MAX(x, 0), (int32_t)TOUCHPAD_X_SPAN);
+        y = CY_MIN(CY_MAX(y, 0), (int32_t)TOUCHPAD_Y_SPAN);
+
+        ptrPosition = &ptrStatus->position[i];
+        ptrPosition->x = (uint16_t)((((uint32_t)x * TOUCHPAD_MAX_POSITION) + (TOUCHPAD_X_SPAN / 2u)) / TOUCHPAD_X_SPAN);
+        ptrPosition->y = (uint16_t)((((uint32_t)y * TOUCHPAD_MAX_POSITION) + (TOUCHPAD_Y_SPAN / 2u)) / TOUCHPAD_Y_SPAN);
+        ptrPosition->z = (uint16_t)CY_MIN(sum, UINT16_MAX);
+        ptrPosition->id = (uint16_t)i;
+    }
+}
+#endif
+
+#if ENABLE_TOUCHPAD_PROCESSING_CHECK
+/*******************************************************************************
+ * Function Name: update_touchpad_check
+ ********************************************************************************
+ * Summary:
+ *  Compares the touch status, the touch count and the positions computed by
+ *  the specialized processing with the ones of the generic processing in the
+ *  widget data, and accounts the processing cycles of both.
+ *
+ * Parameters:
+ *  generic_cycles: CPU cycles of the generic status processing
+ *  specialized_cycles: CPU cycles of the specialized status processing
+ *
+ *******************************************************************************/
+static void update_touchpad_check(uint32_t generic_cycles, uint32_t specialized_cycles)
+{
+    volatile TOUCHPAD_CHECK_REPORT *ptrReport = &host_interface.touchpadCheck;
+    const cy_stc_capsense_touch_t *panelTouch =
+            Cy_CapSense_GetTouchInfo(CY_CAPSENSE_TOUCHPAD_WDGT_ID, &cy_capsense_context);
+    uint32_t active = Cy_CapSense_IsWidgetActive(CY_CAPSENSE_TOUCHPAD_WDGT_ID, &cy_capsense_context);
+    uint32_t mismatch;
+
+    mismatch = ((active != touchpad_status.active) || (panelTouch->numPosition != touchpad_status.numPosition) ||
+                (0 != memcmp(panelTouch->ptrPosition, touchpad_status.position,
+                             touchpad_status.numPosition * sizeof(cy_stc_capsense_position_t))));
+
+    ptrReport->sequence++;
+
+    ptrReport->frames++;
+    if (0u != mismatch)
+    {
+        ptrReport->mismatches++;
+        ptrReport->lastMismatchFrame = ptrReport->frames;
+    }
+
+    ptrReport->genericCycles += generic_cycles;
+    ptrReport->specializedCycles += specialized_cycles;
+
+    if (generic_cycles > ptrReport->maxGenericCycles)
+    {
+        ptrReport->maxGenericCycles = (uint16_t)CY_MIN(generic_cycles, UINT16_MAX);
+    }
+    if (specialized_cycles > ptrReport->maxSpecializedCycles)
+    {
+        ptrReport->maxSpecializedCycles = (uint16_t)CY_MIN(specialized_cycles, UINT16_MAX);
+    }
+
+    ptrReport->sequence++;
+}
+#endif
+
+#if ENABLE_FRAME_JITTER
+/*******************************************************************************
+ * Function Name: update_frame_jitter
+ ********************************************************************************
+ * Summary:
+ *  Accounts the processing time of the frame scanned in prev_capsense_state in
+ *  the bin of the EZI2C interrupts counted since the end of the previous frame.
+ *  Called once at the end of every frame. WOT frames are not accounted as their
+ *  processing time is not reserved in the frame period.
+ *
+ *  Reading the report over EZI2C adds to the load it measures; the host should
+ *  poll it after the load run or at a low rate.
+ *
+ *******************************************************************************/
+static void update_frame_jitter(void)
+{
+    uint32_t process_time = get_elapsed_time_us(frame_start_tick);
+    uint32_t interruptStatus;
+    uint32_t isr_count;
+    uint32_t budget;
+    volatile JITTER_REPORT *ptrReport = &host_interface.jitterReport;
+    volatile JITTER_BIN *ptrBin;
+
+    interruptStatus = Cy_SysLib_EnterCriticalSection();
+    isr_count = ezi2c_isr_count;
+    ezi2c_isr_count = 0u;
+    Cy_SysLib_ExitCriticalSection(interruptStatus);
+
+    if (WOT_MODE == prev_capsense_state)
+    {
+        return;
+    }
+
+    budget = (ACTIVE_MODE == prev_capsense_state) ? ACTIVE_MODE_FRAME_PROCESS_TIME : ALR_MODE_FRAME_PROCESS_TIME;
+    ptrBin = &ptrReport->bin[CY_MIN(isr_count / JITTER_LOAD_BIN_WIDTH, JITTER_LOAD_BINS - 1u)];
+
+    ptrReport->sequence++;
+
+    ptrBin->frames++;
+    ptrBin->totalProcessTime += process_time;
+
+    if (process_time > ptrBin->maxProcessTime)
+    {
+        ptrBin->maxProcessTime = process_time;
+    }
+
+    if (process_time > budget)
+    {
+        ptrBin->deadlineMisses++;
 
-    Cy_SCB_EZI2C_Enable(CYBSP_EZI2C_HW);
+        if (is_touch_active())
+        {
+            ptrBin->touchMisses++;
+        }
+    }
+
+    ptrReport->sequence++;
 }
+#endif
 
+#if ENABLE_ISR_LATENCY
 /*******************************************************************************
-* Function Name: ezi2c_isr
-********************************************************************************
-* Summary:
-* Wrapper function for handling interrupts from EZI2C block.
-*
-*******************************************************************************/
-static void ezi2c_isr(void)
+ * Function Name: record_cpu_wakeup
+ ********************************************************************************
+ * Summary:
+ *  Called in the main loop right after the CPU wakes up from Sleep or Deep
+ *  Sleep, with the interrupts still disabled. Records the time from the Deep
+ *  Sleep exit (the AFTER_TRANSITION callback) to this point and marks the
+ *  wake-up time for the ISR entry latency of the interrupts pending at this
+ *  point, which are the ones that woke up the CPU. An interrupt raised later
+ *  is not counted as a wake-up latency. The hardware wake-up time before the
+ *  callback is not measured as the SysTick is stopped in Deep Sleep.
+ *
+ *******************************************************************************/
+static void record_cpu_wakeup(void)
 {
-    Cy_SCB_EZI2C_Interrupt(CYBSP_EZI2C_HW, &ezi2c_context);
+    cpu_wakeup_tick = Cy_SysTick_GetValue();
+    capsense_wakeup_pending = (uint8_t)NVIC_GetPendingIRQ(CY_MSCLP0_LP_IRQ);
+    ezi2c_wakeup_pending = (uint8_t)NVIC_GetPendingIRQ(CYBSP_EZI2C_IRQ);
+
+    if (0u != deep_sleep_exit_pending)
+    {
+        deep_sleep_exit_pending = 0u;
+        add_to_histogram(&host_interface.latencyReport.deepSleepExitToResume,
+                         get_elapsed_time_us(deep_sleep_exit_tick));
+    }
 }
 
-#if (ENABLE_RUN_TIME_MEASUREMENT || CY_CAPSENSE_GESTURE_EN)
 /*******************************************************************************
- * Function Name: init_sys_tick
+ * Function Name: add_to_histogram
  ********************************************************************************
  * Summary:
- *  initializes the system tick with highest possible value to start counting down.
+ *  Counts the time in its LATENCY_BUCKET_WIDTH bucket and updates the maximum.
+ *
+ * Parameters:
+ *  ptrHistogram: Histogram to update
+ *  time: Time in us
  *
  *******************************************************************************/
-static void init_sys_tick()
+static void add_to_histogram(volatile LATENCY_HISTOGRAM *ptrHistogram, uint32_t time)
 {
-    Cy_SysTick_Init (CY_SYSTICK_CLOCK_SOURCE_CLK_CPU ,SYS_TICK_INTERVAL );
-    cy_capsense_context.ptrCommonContext->timestampInterval = TIMESTAMP_INTERVAL_IN_MILSEC;
-    #if (CY_CAPSENSE_GESTURE_EN)
-    Cy_SysTick_SetCallback(0u,SysTickCallback);
-    #endif
+    ptrHistogram->count[CY_MIN(time / LATENCY_BUCKET_WIDTH, LATENCY_HISTOGRAM_BUCKETS - 1u)]++;
+
+    if (time > ptrHistogram->max)
+    {
+        ptrHistogram->max = time;
+    }
 }
 #endif
 
-#if ENABLE_RUN_TIME_MEASUREMENT
+#if ENABLE_TELEMETRY
 /*******************************************************************************
- * Function Name: start_runtime_measurement
+ * Function Name: update_telemetry
  ********************************************************************************
  * Summary:
- *  Initializes the system tick counter by calling Cy_SysTick_Clear() API.
+ *  Accounts the frame scanned in prev_capsense_state and the transition to
+ *  capsense_state in the telemetry block. Called once at the end of every frame.
+ *
+ *  ACTIVE and ALR frame time is the MSCLP wake up timer and scan time plus the
+ *  measured processing time, or the reserved processing time if the SysTick is
+ *  not running. A WOT frame ended by the timeout lasts WOT_MODE_FRAME_TIME.
+ *  With ENABLE_ILO_TIMEBASE its ILO cycles calibrate the time of the WOT frames
+ *  ended by a touch, which are measured with the timebase. Until the first
+ *  timeout, the nominal ILO frequency is used. Without the timebase a WOT frame
+ *  ended by a touch counts as half of WOT_MODE_FRAME_TIME.
+ *
  *******************************************************************************/
-static void start_runtime_measurement()
+static void update_telemetry(void)
 {
-    Cy_SysTick_Clear();
+    uint32_t from = TELEMETRY_STATE_INDEX(prev_capsense_state);
+    uint32_t to = TELEMETRY_STATE_INDEX(capsense_state);
+    uint32_t frame_time;
+    #if ENABLE_ILO_TIMEBASE
+    uint32_t wot_ilo_ticks;
+    #endif
+    volatile TELEMETRY *ptrTelemetry = &host_interface.telemetry;
+
+    #if (ENABLE_RUN_TIME_MEASUREMENT || CY_CAPSENSE_GESTURE_EN)
+    frame_time = get_elapsed_time_us(frame_start_tick);
+    #else
+    frame_time = (ACTIVE_MODE == prev_capsense_state) ? ACTIVE_MODE_FRAME_PROCESS_TIME : ALR_MODE_FRAME_PROCESS_TIME;
+    #endif
+
+    ptrTelemetry->sequence++;
+
+    ptrTelemetry->stateFrames[from]++;
+
+    switch(prev_capsense_state)
+    {
+        case ACTIVE_MODE:
+            ptrTelemetry->stateTime[from] += (uint64_t)(ACTIVE_MODE_TIMER + ACTIVE_MODE_FRAME_SCAN_TIME + frame_time);
+            break;
+
+        case ALR_MODE:
+            ptrTelemetry->stateTime[from] += (uint64_t)(ALR_MODE_TIMER + ALR_MODE_FRAME_SCAN_TIME + frame_time);
+            break;
+
+        default:
+            #if ENABLE_ILO_TIMEBASE
+            wot_ilo_ticks = wot_end_ilo_ticks - scan_start_ilo_ticks;
+
+            if (ALR_MODE == capsense_state)
+            {
+                ptrTelemetry->wotTimeoutIloTicks = wot_ilo_ticks;
+                ptrTelemetry->stateTime[from] += WOT_MODE_FRAME_TIME;
+            }
+            else if (0u != ptrTelemetry->wotTimeoutIloTicks)
+            {
+                ptrTelemetry->stateTime[from] += ((uint64_t)wot_ilo_ticks * WOT_MODE_FRAME_TIME) /
+                                                 ptrTelemetry->wotTimeoutIloTicks;
+            }
+            else
+            {
+                ptrTelemetry->stateTime[from] += ((uint64_t)wot_ilo_ticks * TIME_IN_US) / ILO_FREQ;
+            }
+            #else
+            /* A touch ends the frame on average halfway through the timeout */
+            ptrTelemetry->stateTime[from] += (ALR_MODE == capsense_state) ? WOT_MODE_FRAME_TIME :
+                                             (WOT_MODE_FRAME_TIME / 2u);
+            #endif
+            break;
+    }
+
+    if (from != to)
+    {
+        ptrTelemetry->transitions[from][to]++;
+
+        if (ACTIVE_MODE == capsense_state)
+        {
+            ptrTelemetry->activeSessionStart = ptrTelemetry->stateTime[to];
+        }
+        else if (ACTIVE_MODE == prev_capsense_state)
+        {
+            if ((ptrTelemetry->stateTime[from] - ptrTelemetry->activeSessionStart) > ptrTelemetry->longestActiveSession)
+            {
+                ptrTelemetry->longestActiveSession = ptrTelemetry->stateTime[from] - ptrTelemetry->activeSessionStart;
+            }
+        }
+    }
+
+    ptrTelemetry->sequence++;
 }
+#endif
 
+#if ENABLE_TUNER
 /*******************************************************************************
- * Function Name: stop_runtime_measurement
+ * Function Name: tuner_task
  ********************************************************************************
  * Summary:
- *  Reads the system tick and converts to time in microseconds(us).
+ *  Establishes synchronized communication with the CAPSENSE Tuner tool and
+ *  publishes the processed frame to the host. The snapshot is published after
+ *  Cy_CapSense_RunTuner(), so it carries the acknowledgement of the command
+ *  just handled.
  *
- *  Returns:
- *  runtime - in microseconds(us)
  *******************************************************************************/
-
-static uint32_t stop_runtime_measurement()
+static void tuner_task(void)
 {
-    uint32_t ticks;
-    uint32_t runtime;
-    ticks=Cy_SysTick_GetValue();
-    ticks= SYS_TICK_INTERVAL - Cy_SysTick_GetValue();
-    runtime=ticks*TIME_PER_TICK_IN_US;
-    return runtime;
+    Cy_CapSense_RunTuner(&cy_capsense_context);
+
+    #if ENABLE_TUNER_SNAPSHOT
+    publish_tuner_snapshot();
+    #endif
 }
 #endif
 
@@ -662,6 +2983,11 @@ void led_control()
    cy_stc_capsense_touch_t *panelTouch=NULL;
    uint8_t touchposition_x, touchposition_y ;
 
+   #if (CY_CAPSENSE_GESTURE_EN)
+   /* The flick LEDs blink from the gesture detection, alternating every LED_BLINK_INTERVAL_IN_MILSEC */
+   uint32_t blink_on = (0u == ((led_delay / LED_BLINK_INTERVAL_IN_MILSEC) & 1u));
+   #endif
+
 /*******************************************************************************
 * If the CSX Touchpad is active, Turn On LED2 and LED3
 * LED2 and LED3 changes the brightness as per the finger
@@ -693,36 +3019,24 @@ void led_control()
 
 		case FLICK_GESTURE_DOWN:
 			/* If Down flick gesture is performed, Blue LED will blink */
-			Cy_TCPWM_PWM_SetCompare0(CYBSP_PWM_2_HW, CYBSP_PWM_2_NUM, CYBSP_PWM_2_config.period0);
-			Cy_SysLib_Delay(50);
-			Cy_TCPWM_PWM_SetCompare0(CYBSP_PWM_2_HW, CYBSP_PWM_2_NUM, 0);
-			Cy_SysLib_Delay(50);
+			Cy_TCPWM_PWM_SetCompare0(CYBSP_PWM_2_HW, CYBSP_PWM_2_NUM, (0u != blink_on) ? CYBSP_PWM_2_config.period0 : 0u);
 			break;
 
 		case FLICK_GESTURE_UP:
 			/* If Up flick gesture is performed, Amber LED will blink */
-			Cy_TCPWM_PWM_SetCompare0(CYBSP_PWM_3_HW, CYBSP_PWM_3_NUM, CYBSP_PWM_3_config.period0);
-			Cy_SysLib_Delay(50);
-			Cy_TCPWM_PWM_SetCompare0(CYBSP_PWM_3_HW, CYBSP_PWM_3_NUM, 0);
-			Cy_SysLib_Delay(50);
+			Cy_TCPWM_PWM_SetCompare0(CYBSP_PWM_3_HW, CYBSP_PWM_3_NUM, (0u != blink_on) ? CYBSP_PWM_3_config.period0 : 0u);
 			break;
 
 		case FLICK_GESTURE_LEFT:
 			/* If Left flick gesture is performed, Blue LED will glow and AMber will blink */
 			Cy_TCPWM_PWM_SetCompare0(CYBSP_PWM_1_HW, CYBSP_PWM_1_NUM, 0);
-			Cy_TCPWM_PWM_SetCompare0(CYBSP_PWM_0_HW, CYBSP_PWM_0_NUM, CYBSP_PWM_0_config.period0);
-			Cy_SysLib_Delay(50);
-			Cy_TCPWM_PWM_SetCompare0(CYBSP_PWM_0_HW, CYBSP_PWM_0_NUM, 0);
-			Cy_SysLib_Delay(50);
+			Cy_TCPWM_PWM_SetCompare0(CYBSP_PWM_0_HW, CYBSP_PWM_0_NUM, (0u != blink_on) ? CYBSP_PWM_0_config.period0 : 0u);
 			break;
 
 		case FLICK_GESTURE_RIGHT:
 			/* If Down flick gesture is performed, Amber will glow and Blue LED will flick */
 			Cy_TCPWM_PWM_SetCompare0(CYBSP_PWM_0_HW, CYBSP_PWM_0_NUM, 0);
-			Cy_TCPWM_PWM_SetCompare0(CYBSP_PWM_1_HW, CYBSP_PWM_1_NUM, CYBSP_PWM_1_config.period0);
-			Cy_SysLib_Delay(50);
-			Cy_TCPWM_PWM_SetCompare0(CYBSP_PWM_1_HW, CYBSP_PWM_1_NUM, 0);
-			Cy_SysLib_Delay(50);
+			Cy_TCPWM_PWM_SetCompare0(CYBSP_PWM_1_HW, CYBSP_PWM_1_NUM, (0u != blink_on) ? CYBSP_PWM_1_config.period0 : 0u);
 			break;
 
 		case FLICK_GESTURE_UP_RIGHT:
@@ -742,10 +3056,16 @@ void led_control()
         #endif
     if (SENSOR_ACTIVE == Cy_CapSense_IsWidgetActive(CY_CAPSENSE_TOUCHPAD_WDGT_ID, &cy_capsense_context))
     {
+        #if ENABLE_POSITION_FILTER
+        (void)panelTouch;
+        touchposition_x = (uint8_t)position_filter.outX;
+        touchposition_y = (uint8_t)position_filter.outY;
+        #else
         panelTouch = Cy_CapSense_GetTouchInfo(CY_CAPSENSE_TOUCHPAD_WDGT_ID, &cy_capsense_context);
 
         touchposition_x = panelTouch->ptrPosition->x;
         touchposition_y = panelTouch->ptrPosition->y;
+        #endif
 
         /* LED3 Turns ON and brightness increases when the finger is swiped from left to right  */
         Cy_TCPWM_PWM_SetCompare0(CYBSP_PWM_1_HW, CYBSP_PWM_1_NUM, (touchposition_x));
@@ -790,6 +3110,29 @@ void PWM_initialisation(void)
     #endif
 
 }
+
+#if (ENABLE_SLEEP_MANAGER && ENABLE_ACTIVE_DEEP_SLEEP)
+/*******************************************************************************
+ * Function Name: is_led_on
+ ********************************************************************************
+ * Summary:
+ *  Returns non-zero if any LED PWM has a non-zero compare value, i.e. an LED is
+ *  on or blinking.
+ *
+ *******************************************************************************/
+static uint32_t is_led_on(void)
+{
+    uint32_t compare = Cy_TCPWM_PWM_GetCompare0(CYBSP_PWM_0_HW, CYBSP_PWM_0_NUM) |
+                       Cy_TCPWM_PWM_GetCompare0(CYBSP_PWM_1_HW, CYBSP_PWM_1_NUM);
+
+    #if (CY_CAPSENSE_GESTURE_EN)
+    compare |= Cy_TCPWM_PWM_GetCompare0(CYBSP_PWM_2_HW, CYBSP_PWM_2_NUM) |
+               Cy_TCPWM_PWM_GetCompare0(CYBSP_PWM_3_HW, CYBSP_PWM_3_NUM);
+    #endif
+
+    return (0u != compare) ? 1u : 0u;
+}
+#endif
 #endif
 
 /*******************************************************************************
@@ -808,11 +3151,15 @@ void PWM_initialisation(void)
  *******************************************************************************/
 void register_callback(void)
 {
+    #if (!ENABLE_SLEEP_MANAGER || ENABLE_TUNER || ENABLE_HOST_INTERFACE)
     /* Register EzI2C Deep Sleep callback */
     Cy_SysPm_RegisterCallback(&ezi2cCallback);
+    #endif
 
-    /* Register Deep Sleep callback */
+    #if (!ENABLE_SLEEP_MANAGER || ENABLE_ISR_LATENCY)
+    /* Register Deep Sleep callback. The sleep manager skips it when it has nothing to do */
     Cy_SysPm_RegisterCallback(&deepSleepCb);
+    #endif
 }
 
 /*******************************************************************************
@@ -836,6 +3183,11 @@ cy_en_syspm_status_t deep_sleep_callback(
 {
     cy_en_syspm_status_t ret_val = CY_SYSPM_FAIL;
 
+    #if (ENABLE_SLEEP_MANAGER && (ENABLE_RUN_TIME_MEASUREMENT || CY_CAPSENSE_GESTURE_EN))
+    uint32_t start_tick = Cy_SysTick_GetValue();
+    uint32_t callback_time;
+    #endif
+
     switch (mode)
     {
         case CY_SYSPM_CHECK_READY:
@@ -851,6 +3203,10 @@ cy_en_syspm_status_t deep_sleep_callback(
             break;
 
         case CY_SYSPM_AFTER_TRANSITION:
+            #if ENABLE_ISR_LATENCY
+            deep_sleep_exit_tick = Cy_SysTick_GetValue();
+            deep_sleep_exit_pending = 1u;
+            #endif
             ret_val = CY_SYSPM_SUCCESS;
             break;
 
@@ -859,9 +3215,260 @@ cy_en_syspm_status_t deep_sleep_callback(
             ret_val = CY_SYSPM_SUCCESS;
             break;
     }
+
+    #if (ENABLE_SLEEP_MANAGER && (ENABLE_RUN_TIME_MEASUREMENT || CY_CAPSENSE_GESTURE_EN))
+    callback_time = get_elapsed_time_us(start_tick);
+
+    if (callback_time > host_interface.sleepReport.customCallbackTime)
+    {
+        host_interface.sleepReport.customCallbackTime = (uint16_t)CY_MIN(callback_time, UINT16_MAX);
+    }
+    #endif
+
+    return ret_val;
+}
+
+#if ENABLE_SLEEP_MANAGER
+/*******************************************************************************
+ * Function Name: ezi2c_deep_sleep_callback
+ ********************************************************************************
+ *
+ * Summary:
+ *  Wrapper of the EzI2C Deep Sleep callback that measures its execution time.
+ *
+ * Parameters:
+ *  callbackParams: The pointer to the callback parameters structure cy_stc_syspm_callback_params_t.
+ *  mode: Callback mode, see cy_en_syspm_callback_mode_t
+ *
+ * Return:
+ *  Entered status, see cy_en_syspm_status_t.
+ *
+ *******************************************************************************/
+cy_en_syspm_status_t ezi2c_deep_sleep_callback(
+        cy_stc_syspm_callback_params_t *callbackParams, cy_en_syspm_callback_mode_t mode)
+{
+    cy_en_syspm_status_t ret_val;
+
+    #if (ENABLE_RUN_TIME_MEASUREMENT || CY_CAPSENSE_GESTURE_EN)
+    uint32_t start_tick = Cy_SysTick_GetValue();
+    uint32_t callback_time;
+    #endif
+
+    ret_val = Cy_SCB_EZI2C_DeepSleepCallback(callbackParams, mode);
+
+    #if (ENABLE_RUN_TIME_MEASUREMENT || CY_CAPSENSE_GESTURE_EN)
+    callback_time = get_elapsed_time_us(start_tick);
+
+    if (callback_time > host_interface.sleepReport.ezi2cCallbackTime)
+    {
+        host_interface.sleepReport.ezi2cCallbackTime = (uint16_t)CY_MIN(callback_time, UINT16_MAX);
+    }
+    #endif
+
     return ret_val;
 }
 
+/*******************************************************************************
+ * Function Name: enter_cpu_low_power
+ ********************************************************************************
+ *
+ * Summary:
+ *  Puts the CPU in the low power mode that fits the idle period. Called in
+ *  place of Cy_SysPm_CpuEnterDeepSleep() with the interrupts disabled.
+ *
+ *  With ENABLE_ILO_TIMEBASE the remaining idle time is predicted from the ILO
+ *  timebase, which keeps counting in Deep Sleep: the idle window of the mode
+ *  less the time elapsed since the scan start. In WOT mode the window repeats
+ *  with every low power scan, the period ends at the earliest at the next one.
+ *  CPU Sleep is used when the remaining time is shorter than the Deep Sleep
+ *  entry, exit and wake-up time, for example after a wake-up by the EZI2C near
+ *  the end of the period. Without the timebase the remaining time is unknown
+ *  and taken as long enough. CPU Sleep is also used when an EZI2C transaction
+ *  is in progress, as the EZI2C callback would reject Deep Sleep and the next
+ *  byte wakes the CPU anyway.
+ *
+ *  In ACTIVE mode the PWM needs CPU Sleep. With ENABLE_ACTIVE_DEEP_SLEEP Deep
+ *  Sleep is used as long as all the LEDs are off. The SysTick stops in Deep
+ *  Sleep, so with the timebase the time spent there is added to the gesture
+ *  timestamp.
+ *
+ *  The Deep Sleep transition time is the SysTick time elapsed over the call,
+ *  the SysTick does not count while in Deep Sleep.
+ *
+ * Parameters:
+ *  idle_window: Time in us from the scan start until the expected end of the
+ *               idle period
+ *
+ *******************************************************************************/
+static void enter_cpu_low_power(uint32_t idle_window)
+{
+    volatile SLEEP_REPORT *ptrReport = &host_interface.sleepReport;
+    cy_en_syspm_status_t status;
+    uint32_t transition_time = ptrReport->transitionTime;
+    uint32_t remaining_ticks;
+
+    #if ENABLE_ILO_TIMEBASE
+    uint32_t window_ticks;
+    uint32_t elapsed_ticks;
+    uint32_t sleep_start_ticks;
+    #endif
+
+    #if (ENABLE_RUN_TIME_MEASUREMENT || CY_CAPSENSE_GESTURE_EN)
+    uint32_t start_tick;
+    #endif
+
+    #if (CY_CAPSENSE_GESTURE_EN && ENABLE_ILO_TIMEBASE)
+    uint32_t interval_ticks;
+    uint32_t transition_ticks;
+    #endif
+
+    if (0u == transition_time)
+    {
+        transition_time = DEEP_SLEEP_TRANSITION_TIME;
+    }
+
+    #if ENABLE_ILO_TIMEBASE
+    sleep_start_ticks = get_ilo_ticks();
+    window_ticks = us_to_ilo_ticks(idle_window);
+    elapsed_ticks = sleep_start_ticks - scan_start_ilo_ticks;
+
+    if (WOT_MODE == prev_capsense_state)
+    {
+        elapsed_ticks %= window_ticks;
+    }
+
+    remaining_ticks = (window_ticks > elapsed_ticks) ? (window_ticks - elapsed_ticks) : 0u;
+    #else
+    remaining_ticks = UINT32_MAX;
+    #endif
+
+    if (0u != (Cy_SCB_EZI2C_GetActivity(CYBSP_EZI2C_HW, &ezi2c_context) & CY_SCB_EZI2C_STATUS_BUSY))
+    {
+        remaining_ticks = 0u;
+    }
+
+    #if ENABLE_PWM_LED
+    /* The PWM counters stop in Deep Sleep, the registers are retained */
+    #if ENABLE_ACTIVE_DEEP_SLEEP
+    if ((ACTIVE_MODE == prev_capsense_state) && (0u != is_led_on()))
+    #else
+    if (ACTIVE_MODE == prev_capsense_state)
+    #endif
+    {
+        remaining_ticks = 0u;
+    }
+    #endif
+
+    /* The elapsed time is short by up to one ILO cycle */
+    if (remaining_ticks <= (us_to_ilo_ticks(transition_time + DEEP_SLEEP_WAKEUP_TIME) + 1u))
+    {
+        ptrReport->sleepCount++;
+        Cy_SysPm_CpuEnterSleep();
+        return;
+    }
+
+    #if (ENABLE_RUN_TIME_MEASUREMENT || CY_CAPSENSE_GESTURE_EN)
+    start_tick = Cy_SysTick_GetValue();
+    #endif
+
+    status = Cy_SysPm_CpuEnterDeepSleep();
+
+    #if (ENABLE_RUN_TIME_MEASUREMENT || CY_CAPSENSE_GESTURE_EN)
+    transition_time = get_elapsed_time_us(start_tick);
+
+    if (transition_time > ptrReport->maxTransitionTime)
+    {
+        ptrReport->maxTransitionTime = (uint16_t)CY_MIN(transition_time, UINT16_MAX);
+    }
+    #endif
+
+    if (CY_SYSPM_SUCCESS == status)
+    {
+        ptrReport->deepSleepCount++;
+
+        #if (ENABLE_RUN_TIME_MEASUREMENT || CY_CAPSENSE_GESTURE_EN)
+        /* Track the transition time, weighting the latest measurement by 1/8 */
+        if (0u == ptrReport->transitionTime)
+        {
+            ptrReport->transitionTime = (uint16_t)CY_MIN(transition_time, UINT16_MAX);
+        }
+        else
+        {
+            ptrReport->transitionTime = (uint16_t)(((7u * (uint32_t)ptrReport->transitionTime) +
+                                                    CY_MIN(transition_time, UINT16_MAX)) >> 3u);
+        }
+        #endif
+
+        #if (CY_CAPSENSE_GESTURE_EN && ENABLE_ILO_TIMEBASE)
+        /* Advance the gesture timestamp by the Deep Sleep time, less the transition
+         * counted by the SysTick */
+        transition_ticks = us_to_ilo_ticks(transition_time);
+        gesture_deep_sleep_ticks += get_ilo_ticks() - sleep_start_ticks;
+        gesture_deep_sleep_ticks -= CY_MIN(transition_ticks, gesture_deep_sleep_ticks);
+
+        interval_ticks = us_to_ilo_ticks(TIMESTAMP_INTERVAL_IN_MILSEC * 1000u);
+
+        while (gesture_deep_sleep_ticks >= interval_ticks)
+        {
+            gesture_deep_sleep_ticks -= interval_ticks;
+            SysTickCallback();
+        }
+        #endif
+    }
+    else
+    {
+        ptrReport->deepSleepFailCount++;
+    }
+}
+
+#if ENABLE_ILO_TIMEBASE
+/*******************************************************************************
+ * Function Name: update_ilo_estimate
+ ********************************************************************************
+ *
+ * Summary:
+ *  Measures the ILO frequency on a frame that just completed: the MSCLP wake-up
+ *  timer is compensated for the ILO error, so the scan ends one idle window
+ *  after the scan start. Called at the end of the scan of the ACTIVE and ALR
+ *  frames.
+ *
+ * Parameters:
+ *  idle_window: Time in us from the scan start until the end of the scan
+ *
+ *******************************************************************************/
+static void update_ilo_estimate(uint32_t idle_window)
+{
+    uint32_t ticks_per_ms = ((get_ilo_ticks() - scan_start_ilo_ticks) * 256000u) / idle_window;
+
+    if ((ticks_per_ms >= ILO_TICKS_PER_MS_MIN) && (ticks_per_ms <= ILO_TICKS_PER_MS_MAX))
+    {
+        /* Weighting the latest measurement by 1/8 */
+        ilo_ticks_per_ms = ((7u * ilo_ticks_per_ms) + ticks_per_ms) >> 3u;
+    }
+}
+#endif
+
+/*******************************************************************************
+ * Function Name: us_to_ilo_ticks
+ ********************************************************************************
+ *
+ * Summary:
+ *  Converts a time up to the WOT scan interval to ILO cycles at the measured
+ *  ILO frequency.
+ *
+ * Parameters:
+ *  time_us: Time in us
+ *
+ * Return:
+ *  ILO cycles
+ *
+ *******************************************************************************/
+static uint32_t us_to_ilo_ticks(uint32_t time_us)
+{
+    return (time_us * ilo_ticks_per_ms) / 256000u;
+}
+#endif
+
 
 
 #if (CY_CAPSENSE_GESTURE_EN)
@@ -923,14 +3530,31 @@ void SysTickCallback(void)
 {
     Cy_CapSense_IncrementGestureTimestamp(&cy_capsense_context);
 
-    if((led_delay + TIMESTAMP_INTERVAL_IN_MILSEC) < MAX_COUNTER_VALUE)
+    advance_gesture_timers(TIMESTAMP_INTERVAL_IN_MILSEC);
+}
+
+/*******************************************************************************
+ * Function Name: advance_gesture_timers
+ ********************************************************************************
+ * Summary:
+ * Advances the LED on time and double click interval timers. This is the only
+ * place the time base enters the double click and LED timing, so the timing
+ * logic can be driven with exact timestamps independently of the SysTick.
+ *
+ * Parameters:
+ *  elapsed_ms: Time in milliseconds since the previous call
+ *
+ *******************************************************************************/
+void advance_gesture_timers(uint32_t elapsed_ms)
+{
+    if((led_delay + elapsed_ms) < MAX_COUNTER_VALUE)
     {
-        led_delay += TIMESTAMP_INTERVAL_IN_MILSEC;
+        led_delay += elapsed_ms;
     }
 
-    if(((clickIntervalTimer + TIMESTAMP_INTERVAL_IN_MILSEC) < MAX_COUNTER_VALUE)&&(startDoubleClickTimer))
+    if(((clickIntervalTimer + elapsed_ms) < MAX_COUNTER_VALUE)&&(startDoubleClickTimer))
     {
-        clickIntervalTimer += TIMESTAMP_INTERVAL_IN_MILSEC;
+        clickIntervalTimer += elapsed_ms;
     }
 }
 #endif
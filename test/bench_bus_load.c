@@ -0,0 +1,461 @@
+/******************************************************************************
+* File Name: bench_bus_load.c
+*
+* Description: Frame jitter under EZI2C host load (ENABLE_FRAME_JITTER). A
+* scripted host polls the Tuner data and the host interface at increasing
+* rates and writes a widget parameter, moving the bytes at the I2C bus speed,
+* while a touch trace with swipes and short taps is replayed. For every load
+* level the benchmark reports the frame period jitter measured at the scan
+* ends, the deadline misses counted by the firmware, the Tuner snapshots
+* skipped, and the taps not seen in any frame. The taps last a little longer
+* than the nominal frame period, so they are missed once the host load and the
+* processing time stretch the frames beyond them. The model is deterministic,
+* so the curve is reproducible.
+*
+* Usage: run [--check FILE | --write FILE]
+* --write stores the curve as the reference, --check fails if the curve is
+* worse than the reference beyond the tolerances below.
+*
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "sim.h"
+
+#define main firmware_main
+#include "main.c"
+#undef main
+#include "firmware_reset.h"
+
+#define MS(ms)                  SIM_US((uint64_t)(ms) * 1000u)
+
+/* 400 kHz bus, 9 bits per byte */
+#define BUS_BYTE_NS             (22500u)
+#define BUS_IDLE_US             (50u)
+
+/* Bytes of the host interface read by every poll */
+#define HOST_INTERFACE_READ     (64u)
+
+/* One Tuner parameter write every this many polls */
+#define WRITE_EVERY_POLLS       (16u)
+
+/* Run time and the start of the measurement, after the first frames */
+#define RUN_TIME                MS(4000u)
+#define MEASURE_START           MS(250u)
+
+/* Touch trace, repeated every TRACE_PERIOD: a swipe, then TAP_COUNT taps of TAP_LENGTH every TAP_SPACING.
+ * The spacing is not a multiple of the frame period, so the taps start at all the phases of the frame, and
+ * the share of the taps missed grows with the excess of the frame period over the tap */
+#define TRACE_PERIOD            MS(1000u)
+#define SWIPE_END               MS(300u)
+#define TAP_START               MS(350u)
+#define TAP_SPACING             SIM_US(25700u)
+#define TAP_LENGTH              MS(8u)
+#define TAP_COUNT               (24u)
+
+
+/* Gate tolerances: the longest period in %, the counts in % plus an absolute margin */
+#define GATE_PERIOD_TOLERANCE   (2u)
+#define GATE_COUNT_TOLERANCE    (10u)
+#define GATE_COUNT_MARGIN       (2u)
+
+/* Host polls per second of each load level, the last ones saturate the bus */
+static const uint32_t load_levels[] = { 0u, 10u, 25u, 50u, 75u, 100u, 125u, 150u, 200u };
+#define LOAD_LEVEL_COUNT        (sizeof(load_levels) / sizeof(load_levels[0]))
+
+/* Series of the curve: the bytes moved per EZI2C interrupt, the SCB FIFO depth
+ * or one byte as the worst case, and the Cy_CapSense_ProcessAllWidgets() time,
+ * the nominal one, one close to the reserved processing time, or one over it */
+typedef struct
+{
+    uint32_t fifo;
+    uint32_t processUs;
+} load_series_t;
+
+static const load_series_t load_series[] =
+{
+    { 8u, 150u },
+    { 1u, 150u },
+    { 8u, 300u },
+    { 1u, 300u },
+    { 1u, 800u },
+};
+#define LOAD_SERIES_COUNT       (sizeof(load_series) / sizeof(load_series[0]))
+#define RESULT_COUNT            (LOAD_LEVEL_COUNT * LOAD_SERIES_COUNT)
+
+typedef struct
+{
+    uint32_t fifo;              /* Bytes per EZI2C interrupt */
+    uint32_t processUs;         /* Cy_CapSense_ProcessAllWidgets() time */
+    uint32_t polls;             /* Host polls per second */
+    uint32_t isrPerSecond;      /* EZI2C interrupts per second */
+    uint32_t frames;
+    double meanPeriod;          /* Frame period in us */
+    double stdPeriod;
+    uint32_t maxPeriod;
+    uint32_t lateFrames;
+    uint32_t deadlineMisses;    /* Counted by the firmware */
+    uint32_t snapshotSkips;
+    uint32_t taps;
+    uint32_t missedTaps;
+} load_result_t;
+
+/* Host transactions of one poll */
+typedef enum
+{
+    TXN_TUNER_READ,
+    TXN_HOST_READ,
+    TXN_TUNER_WRITE,
+    TXN_DONE
+} txn_type_t;
+
+static uint32_t bus_fifo_bytes;
+static uint32_t poll_rate;
+static uint32_t poll_count;
+static uint64_t poll_start;
+static txn_type_t txn_type;
+static uint32_t txn_offset;
+static uint32_t txn_size;
+static uint32_t txn_done;
+static uint8_t read_data[sizeof(cy_stc_capsense_tuner_t)];
+static uint16_t write_data;
+static uint32_t bus_isr_count;
+
+static uint64_t last_scan_end;
+static uint64_t period_count;
+static double period_sum;
+static double period_squares;
+static uint32_t period_max;
+static uint32_t late_frames;
+static uint8_t tap_seen[(RUN_TIME / TRACE_PERIOD) + 1u][TAP_COUNT];
+
+static void txn_step(void *arg);
+
+/*******************************************************************************
+* Scripted host
+*******************************************************************************/
+static void start_transaction(void)
+{
+    txn_done = 0u;
+    bus_isr_count++;
+    switch (txn_type)
+    {
+        case TXN_TUNER_READ:
+            txn_offset = 0u;
+            txn_size = sim_ezi2c_buffer_size(SIM_EZI2C_BUFFER1);
+            sim_ezi2c_start(SIM_EZI2C_BUFFER1, 0u, txn_offset);
+            break;
+
+        case TXN_HOST_READ:
+            txn_offset = 0u;
+            txn_size = CY_MIN(HOST_INTERFACE_READ, sim_ezi2c_buffer_size(SIM_EZI2C_BUFFER2));
+            sim_ezi2c_start(SIM_EZI2C_BUFFER2, 0u, txn_offset);
+            break;
+
+        default:
+            /* Writes the finger threshold with its current value */
+            txn_offset = offsetof(cy_stc_capsense_tuner_t, wdgtContext[CY_CAPSENSE_TOUCHPAD_WDGT_ID].fingerTh);
+            txn_size = sizeof(write_data);
+            write_data = cy_capsense_tuner.wdgtContext[CY_CAPSENSE_TOUCHPAD_WDGT_ID].fingerTh;
+            sim_ezi2c_start(SIM_EZI2C_BUFFER1, 1u, txn_offset);
+            break;
+    }
+    sim_schedule(sim_now() + SIM_US(2u * BUS_BYTE_NS / 1000u), txn_step, NULL);
+}
+
+static void start_poll(void *arg)
+{
+    (void)arg;
+    poll_start = sim_now();
+    txn_type = TXN_TUNER_READ;
+    start_transaction();
+}
+
+/* Moves the next FIFO of bytes, or ends the transaction and starts the next one */
+static void txn_step(void *arg)
+{
+    uint32_t chunk = CY_MIN(bus_fifo_bytes, txn_size - txn_done);
+    uint64_t next;
+
+    (void)arg;
+
+    bus_isr_count++;
+    if (0u != chunk)
+    {
+        if (TXN_TUNER_WRITE == txn_type)
+        {
+            sim_ezi2c_write((uint8_t *)&write_data + txn_done, chunk);
+        }
+        else
+        {
+            sim_ezi2c_read(&read_data[txn_done], chunk);
+        }
+        txn_done += chunk;
+        sim_schedule(sim_now() + SIM_US(((uint64_t)chunk * BUS_BYTE_NS) / 1000u), txn_step, NULL);
+        return;
+    }
+
+    sim_ezi2c_stop();
+
+    txn_type = (txn_type_t)(txn_type + 1);
+    if ((TXN_TUNER_WRITE == txn_type) && (0u != (poll_count % WRITE_EVERY_POLLS)))
+    {
+        txn_type = TXN_DONE;
+    }
+
+    if (TXN_DONE != txn_type)
+    {
+        sim_schedule(sim_now() + SIM_US(BUS_IDLE_US), (sim_event_fn)start_transaction, NULL);
+        return;
+    }
+
+    /* Next poll at the poll rate, or right away when the bus is saturated */
+    poll_count++;
+    next = poll_start + (SIM_US(1000000u) / poll_rate);
+    if (next < (sim_now() + SIM_US(BUS_IDLE_US)))
+    {
+        next = sim_now() + SIM_US(BUS_IDLE_US);
+    }
+    sim_schedule(next, start_poll, NULL);
+}
+
+/*******************************************************************************
+* Touch trace, sampled at every scan end
+*******************************************************************************/
+static uint32_t touch_source(uint64_t time, sim_touch_t *touches)
+{
+    uint64_t cycle = time / TRACE_PERIOD;
+    uint64_t t = time % TRACE_PERIOD;
+    uint32_t period;
+    uint32_t tap;
+
+    /* Frame period of the ACTIVE frames */
+    if ((ACTIVE_MODE == prev_capsense_state) && (0u != last_scan_end) && (time >= MEASURE_START))
+    {
+        period = (uint32_t)((time - last_scan_end) / SIM_CYCLES_PER_US);
+        period_count++;
+        period_sum += period;
+        period_squares += (double)period * period;
+        period_max = CY_MAX(period_max, period);
+
+        /* Late when longer than the refresh period */
+        if (period > (TIME_IN_US / ACTIVE_MODE_REFRESH_RATE))
+        {
+            late_frames++;
+        }
+    }
+    last_scan_end = time;
+
+    touches[0].z = 100u;
+
+    if (t < SWIPE_END)
+    {
+        touches[0].x = (uint16_t)(40u + (175u * t) / SWIPE_END);
+        touches[0].y = 128u;
+        return 1u;
+    }
+
+    if (t >= TAP_START)
+    {
+        tap = (uint32_t)((t - TAP_START) / TAP_SPACING);
+
+        if ((tap < TAP_COUNT) && (((t - TAP_START) % TAP_SPACING) < TAP_LENGTH))
+        {
+            tap_seen[cycle][tap] = 1u;
+            touches[0].x = 128u;
+            touches[0].y = 128u;
+            return 1u;
+        }
+    }
+    return 0u;
+}
+
+/*******************************************************************************
+* Load levels
+*******************************************************************************/
+static void run_level(const load_series_t *ptrSeries, uint32_t polls, load_result_t *ptrResult)
+{
+    uint32_t cycle;
+    uint32_t i;
+
+    firmware_reset();
+
+    /* Modeled execution times of the middleware, drivers and interrupts */
+    sim_process_cycles = SIM_US(ptrSeries->processUs);
+    sim_process_widget_cycles = SIM_US(120u);
+    sim_gesture_cycles = SIM_US(30u);
+    sim_tuner_cycles = SIM_US(15u);
+    sim_capsense_isr_cycles = SIM_US(8u);
+    sim_ezi2c_isr_cycles = SIM_US(12u);
+    sim_isr_overhead_cycles = SIM_CYCLES_PER_US / 2u;
+
+    sim_touch_source = touch_source;
+    last_scan_end = 0u;
+    period_count = 0u;
+    period_sum = 0.0;
+    period_squares = 0.0;
+    period_max = 0u;
+    late_frames = 0u;
+    memset(tap_seen, 0, sizeof(tap_seen));
+
+    bus_fifo_bytes = ptrSeries->fifo;
+    poll_rate = polls;
+    poll_count = 0u;
+    bus_isr_count = 0u;
+    if (0u != polls)
+    {
+        sim_schedule(MEASURE_START / 2u, start_poll, NULL);
+    }
+
+    sim_run(firmware_main, RUN_TIME);
+
+    memset(ptrResult, 0, sizeof(*ptrResult));
+    ptrResult->fifo = ptrSeries->fifo;
+    ptrResult->processUs = ptrSeries->processUs;
+    ptrResult->polls = polls;
+    ptrResult->frames = (uint32_t)period_count;
+    if (0u != period_count)
+    {
+        ptrResult->meanPeriod = period_sum / period_count;
+        ptrResult->stdPeriod = sqrt(fmax(0.0, (period_squares / period_count) -
+                                         (ptrResult->meanPeriod * ptrResult->meanPeriod)));
+    }
+    ptrResult->maxPeriod = period_max;
+    ptrResult->lateFrames = late_frames;
+    ptrResult->snapshotSkips = host_interface.jitterReport.snapshotSkips;
+
+    for (i = 0u; i < JITTER_LOAD_BINS; i++)
+    {
+        ptrResult->deadlineMisses += host_interface.jitterReport.bin[i].deadlineMisses;
+    }
+    ptrResult->isrPerSecond = (uint32_t)(((uint64_t)bus_isr_count * MS(1000u)) / (RUN_TIME - (MEASURE_START / 2u)));
+
+    /* Taps of the complete trace periods after the measurement start */
+    for (cycle = 1u; cycle < (RUN_TIME / TRACE_PERIOD); cycle++)
+    {
+        for (i = 0u; i < TAP_COUNT; i++)
+        {
+            ptrResult->taps++;
+            ptrResult->missedTaps += (0u == tap_seen[cycle][i]) ? 1u : 0u;
+        }
+    }
+}
+
+/*******************************************************************************
+* Reference curve
+*******************************************************************************/
+static int write_reference(const char *path, const load_result_t *results)
+{
+    FILE *file = fopen(path, "w");
+    uint32_t i;
+
+    if (NULL == file)
+    {
+        perror(path);
+        return 1;
+    }
+    fprintf(file, "# bytes/isr process_us polls/s late_frames max_period_us deadline_misses missed_taps\n");
+    for (i = 0u; i < RESULT_COUNT; i++)
+    {
+        fprintf(file, "%u %u %u %u %u %u %u\n", (unsigned)results[i].fifo, (unsigned)results[i].processUs,
+                (unsigned)results[i].polls,
+                (unsigned)results[i].lateFrames,
+                (unsigned)results[i].maxPeriod, (unsigned)results[i].deadlineMisses,
+                (unsigned)results[i].missedTaps);
+    }
+    fclose(file);
+    return 0;
+}
+
+static uint32_t count_limit(uint32_t reference)
+{
+    return reference + ((reference * GATE_COUNT_TOLERANCE) / 100u) + GATE_COUNT_MARGIN;
+}
+
+static int check_reference(const char *path, const load_result_t *results)
+{
+    FILE *file = fopen(path, "r");
+    char line[128];
+    unsigned fifo;
+    unsigned process;
+    unsigned polls;
+    unsigned late;
+    unsigned period;
+    unsigned misses;
+    unsigned taps;
+    uint32_t checked = 0u;
+    uint32_t i;
+
+    if (NULL == file)
+    {
+        perror(path);
+        return 1;
+    }
+    while (NULL != fgets(line, sizeof(line), file))
+    {
+        if (7 != sscanf(line, "%u %u %u %u %u %u %u", &fifo, &process, &polls, &late, &period, &misses, &taps))
+        {
+            continue;
+        }
+        for (i = 0u; i < RESULT_COUNT; i++)
+        {
+            if ((results[i].fifo != fifo) || (results[i].processUs != process) || (results[i].polls != polls))
+            {
+                continue;
+            }
+            checked++;
+            SIM_CHECK(results[i].lateFrames <= count_limit(late));
+            SIM_CHECK(results[i].maxPeriod <= (period + ((period * GATE_PERIOD_TOLERANCE) / 100u)));
+            SIM_CHECK(results[i].deadlineMisses <= count_limit(misses));
+            SIM_CHECK(results[i].missedTaps <= (taps + 1u));
+            if ((results[i].lateFrames > count_limit(late)) ||
+                (results[i].maxPeriod > (period + ((period * GATE_PERIOD_TOLERANCE) / 100u))) ||
+                (results[i].deadlineMisses > count_limit(misses)) || (results[i].missedTaps > (taps + 1u)))
+            {
+                printf("  regression at %u bytes/isr, %u us, %u polls/s: reference %u late, %u us, %u misses, "
+                       "%u missed taps\n", fifo, process, polls, late, period, misses, taps);
+            }
+        }
+    }
+    fclose(file);
+    SIM_CHECK(RESULT_COUNT == checked);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    static load_result_t results[RESULT_COUNT];
+    uint32_t i;
+
+    printf("Frame period under EZI2C load: nominal %u us, Tuner data %u bytes, host interface read %u bytes\n",
+           (unsigned)(TIME_IN_US / ACTIVE_MODE_REFRESH_RATE), (unsigned)sizeof(cy_capsense_tuner),
+           (unsigned)HOST_INTERFACE_READ);
+    printf("Reserved processing time %u us\n", (unsigned)ACTIVE_MODE_FRAME_PROCESS_TIME);
+    printf("%9s %10s %8s %8s %7s %9s %8s %8s %6s %7s %6s %6s\n", "bytes/isr", "process us", "polls/s",
+           "isr/s", "frames", "mean us", "std us", "max us", "late", "misses", "skips", "missed");
+
+    for (i = 0u; i < RESULT_COUNT; i++)
+    {
+        run_level(&load_series[i / LOAD_LEVEL_COUNT], load_levels[i % LOAD_LEVEL_COUNT], &results[i]);
+        printf("%9u %10u %8u %8u %7u %9.1f %8.1f %8u %6u %7u %6u %3u/%-3u\n", (unsigned)results[i].fifo,
+               (unsigned)results[i].processUs, (unsigned)results[i].polls,
+               (unsigned)results[i].isrPerSecond, (unsigned)results[i].frames, results[i].meanPeriod,
+               results[i].stdPeriod, (unsigned)results[i].maxPeriod, (unsigned)results[i].lateFrames,
+               (unsigned)results[i].deadlineMisses, (unsigned)results[i].snapshotSkips,
+               (unsigned)results[i].missedTaps, (unsigned)results[i].taps);
+    }
+
+    if ((3 == argc) && (0 == strcmp(argv[1], "--write")))
+    {
+        return write_reference(argv[2], results);
+    }
+    if ((3 == argc) && (0 == strcmp(argv[1], "--check")))
+    {
+        if (0 != check_reference(argv[2], results))
+        {
+            return 1;
+        }
+    }
+    return sim_report("bench_bus_load");
+}
@@ -0,0 +1,306 @@
+/******************************************************************************
+* File Name: bench_position_filter.c
+*
+* Description: Benchmark of the position filter (ENABLE_POSITION_FILTER) on
+* swipe traces replayed through the firmware main loop. For every frame, the
+* filtered and the raw positions of the position report are compared with the
+* finger position one frame period after the scan, when the position is used.
+*
+* Usage: run [trace ...]
+* Without arguments the built-in traces are replayed. A trace file has one
+* "time_ms x y" finger position per line, in touchpad units; the finger
+* position is interpolated between the lines and the touch lasts from the
+* first to the last line.
+*
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "sim.h"
+
+#define main firmware_main
+#include "main.c"
+#undef main
+#include "firmware_reset.h"
+
+#define TRACE_MAX_POINTS        (1024u)
+
+/* Touchdown time, in the ACTIVE state after the reset */
+#define TRACE_START_US          (500000u)
+
+/* Peak position noise of the measured position in touchpad units */
+#define TRACE_NOISE             (1.5)
+
+/* Time between the scan and the use of the position, one ACTIVE frame period */
+#define TRACE_USE_DELAY_US      (TIME_IN_US / ACTIVE_MODE_REFRESH_RATE)
+
+typedef struct
+{
+    double time;                /* ms from the touchdown */
+    double x;
+    double y;
+} trace_point_t;
+
+typedef struct
+{
+    char name[64];
+    uint32_t count;
+    trace_point_t point[TRACE_MAX_POINTS];
+} trace_t;
+
+typedef struct
+{
+    uint32_t frames;
+    double sumSquares;
+    double max;
+} error_stats_t;
+
+static const trace_t *trace;
+static uint32_t noise_seed;
+static uint32_t last_sequence;
+static error_stats_t raw_error;
+static error_stats_t filtered_error;
+
+/* Finger position at the given time, returns zero outside of the touch */
+static uint32_t trace_position(uint64_t time, double *x, double *y)
+{
+    double ms;
+    double f;
+    uint32_t i;
+
+    if (time < SIM_US(TRACE_START_US))
+    {
+        return 0u;
+    }
+    ms = (double)(time - SIM_US(TRACE_START_US)) / SIM_CYCLES_PER_US / 1000.0;
+
+    for (i = 1u; i < trace->count; i++)
+    {
+        if (ms <= trace->point[i].time)
+        {
+            f = (ms - trace->point[i - 1u].time) / (trace->point[i].time - trace->point[i - 1u].time);
+            *x = trace->point[i - 1u].x + f * (trace->point[i].x - trace->point[i - 1u].x);
+            *y = trace->point[i - 1u].y + f * (trace->point[i].y - trace->point[i - 1u].y);
+            return 1u;
+        }
+    }
+    return 0u;
+}
+
+/* Repeatable uniform noise in [-TRACE_NOISE, TRACE_NOISE] */
+static double noise(void)
+{
+    noise_seed = noise_seed * 1103515245u + 12345u;
+    return TRACE_NOISE * (((double)((noise_seed >> 8u) & 0xFFFFu) / 32767.5) - 1.0);
+}
+
+static uint16_t measured(double position)
+{
+    double value = floor(position + noise() + 0.5);
+
+    return (uint16_t)((value < 0.0) ? 0.0 : ((value > TOUCHPAD_MAX_POSITION) ? TOUCHPAD_MAX_POSITION : value));
+}
+
+static uint32_t touch_source(uint64_t time, sim_touch_t *touches)
+{
+    double x;
+    double y;
+
+    if (0u == trace_position(time, &x, &y))
+    {
+        return 0u;
+    }
+    touches[0].x = measured(x);
+    touches[0].y = measured(y);
+    touches[0].z = 100u;
+    return 1u;
+}
+
+static void add_error(error_stats_t *stats, double x, double y, double trueX, double trueY)
+{
+    double error = sqrt((x - trueX) * (x - trueX) + (y - trueY) * (y - trueY));
+
+    stats->frames++;
+    stats->sumSquares += error * error;
+    if (error > stats->max)
+    {
+        stats->max = error;
+    }
+}
+
+/* Compares the positions of every new report with the finger position when they are used */
+static void compare_report(void)
+{
+    volatile POSITION_REPORT *ptrReport = &host_interface.positionReport;
+    double trueX;
+    double trueY;
+
+    if ((last_sequence == ptrReport->sequence) || (0u == ptrReport->touch))
+    {
+        return;
+    }
+    last_sequence = ptrReport->sequence;
+
+    if (0u != trace_position(sim_scan_end_time + SIM_US(TRACE_USE_DELAY_US), &trueX, &trueY))
+    {
+        add_error(&raw_error, ptrReport->rawX, ptrReport->rawY, trueX, trueY);
+        add_error(&filtered_error, ptrReport->x, ptrReport->y, trueX, trueY);
+    }
+}
+
+static double rms(const error_stats_t *stats)
+{
+    return (0u != stats->frames) ? sqrt(stats->sumSquares / stats->frames) : 0.0;
+}
+
+static void run_trace(const trace_t *t, error_stats_t *total_raw, error_stats_t *total_filtered)
+{
+    uint64_t end = SIM_US(TRACE_START_US) + SIM_US((uint64_t)(t->point[t->count - 1u].time * 1000.0)) +
+                   SIM_US(100000u);
+
+    firmware_reset();
+
+    trace = t;
+    noise_seed = 1u;
+    last_sequence = 0u;
+    memset(&raw_error, 0, sizeof(raw_error));
+    memset(&filtered_error, 0, sizeof(filtered_error));
+    sim_touch_source = touch_source;
+    sim_sleep_hook = compare_report;
+
+    sim_run(firmware_main, end);
+
+    printf("%-24s %6u %9.2f %9.2f %9.2f %9.2f\n", t->name, raw_error.frames,
+           rms(&raw_error), raw_error.max, rms(&filtered_error), filtered_error.max);
+
+    total_raw->frames += raw_error.frames;
+    total_raw->sumSquares += raw_error.sumSquares;
+    total_raw->max = fmax(total_raw->max, raw_error.max);
+    total_filtered->frames += filtered_error.frames;
+    total_filtered->sumSquares += filtered_error.sumSquares;
+    total_filtered->max = fmax(total_filtered->max, filtered_error.max);
+}
+
+/* Straight swipe at a constant speed in positions per second */
+static void make_swipe(trace_t *t, const char *name, double x0, double y0, double x1, double y1, double speed)
+{
+    double length = sqrt((x1 - x0) * (x1 - x0) + (y1 - y0) * (y1 - y0));
+
+    snprintf(t->name, sizeof(t->name), "%s", name);
+    t->point[0] = (trace_point_t){ 0.0, x0, y0 };
+    t->point[1] = (trace_point_t){ 1000.0 * length / speed, x1, y1 };
+    t->count = 2u;
+}
+
+/* Swipe accelerating from rest and decelerating to a stop, held for hold_ms at both ends */
+static void make_eased_swipe(trace_t *t, const char *name, double x0, double y0, double x1, double y1,
+                             double duration_ms, double hold_ms)
+{
+    uint32_t i;
+    uint32_t steps = 32u;
+    double f;
+
+    snprintf(t->name, sizeof(t->name), "%s", name);
+    t->point[0] = (trace_point_t){ 0.0, x0, y0 };
+    for (i = 0u; i <= steps; i++)
+    {
+        f = 0.5 - 0.5 * cos(M_PI * i / steps);
+        t->point[i + 1u] = (trace_point_t){ hold_ms + duration_ms * i / steps, x0 + f * (x1 - x0), y0 + f * (y1 - y0) };
+    }
+    t->point[steps + 2u] = (trace_point_t){ 2.0 * hold_ms + duration_ms, x1, y1 };
+    t->count = steps + 3u;
+}
+
+/* Circle around the touchpad center at a constant speed */
+static void make_circle(trace_t *t, const char *name, double radius, double period_ms)
+{
+    uint32_t i;
+    uint32_t steps = 64u;
+
+    snprintf(t->name, sizeof(t->name), "%s", name);
+    for (i = 0u; i <= steps; i++)
+    {
+        t->point[i] = (trace_point_t){ period_ms * i / steps, 128.0 + radius * cos(2.0 * M_PI * i / steps),
+                                       128.0 + radius * sin(2.0 * M_PI * i / steps) };
+    }
+    t->count = steps + 1u;
+}
+
+static int load_trace(trace_t *t, const char *path)
+{
+    FILE *file = fopen(path, "r");
+    char line[128];
+
+    if (NULL == file)
+    {
+        perror(path);
+        return -1;
+    }
+    snprintf(t->name, sizeof(t->name), "%s", path);
+    t->count = 0u;
+    while ((t->count < TRACE_MAX_POINTS) && (NULL != fgets(line, sizeof(line), file)))
+    {
+        trace_point_t *p = &t->point[t->count];
+
+        if (3 == sscanf(line, "%lf %lf %lf", &p->time, &p->x, &p->y))
+        {
+            p->time -= t->point[0].time;
+            t->count++;
+        }
+    }
+    fclose(file);
+
+    if (t->count < 2u)
+    {
+        fprintf(stderr, "%s: fewer than two points\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    static trace_t traces[8];
+    error_stats_t total_raw = { 0u, 0.0, 0.0 };
+    error_stats_t total_filtered = { 0u, 0.0, 0.0 };
+    uint32_t count = 0u;
+    int i;
+
+    if (argc > 1)
+    {
+        for (i = 1; (i < argc) && (count < 8u); i++)
+        {
+            if (0 != load_trace(&traces[count], argv[i]))
+            {
+                return 1;
+            }
+            count++;
+        }
+    }
+    else
+    {
+        make_swipe(&traces[count++], "swipe x 200 pos/s", 20.0, 128.0, 235.0, 128.0, 200.0);
+        make_swipe(&traces[count++], "swipe x 600 pos/s", 20.0, 128.0, 235.0, 128.0, 600.0);
+        make_swipe(&traces[count++], "swipe y 1200 pos/s", 128.0, 235.0, 128.0, 20.0, 1200.0);
+        make_swipe(&traces[count++], "swipe xy 800 pos/s", 20.0, 20.0, 235.0, 235.0, 800.0);
+        make_eased_swipe(&traces[count++], "eased swipe 300 ms", 30.0, 60.0, 225.0, 190.0, 300.0, 200.0);
+        make_eased_swipe(&traces[count++], "eased swipe 120 ms", 225.0, 128.0, 30.0, 128.0, 120.0, 200.0);
+        make_circle(&traces[count++], "circle r 80 in 1 s", 80.0, 1000.0);
+        make_circle(&traces[count++], "circle r 80 in 400 ms", 80.0, 400.0);
+    }
+
+    printf("Position error vs the finger %u us after the scan, noise +-%.1f, alpha %u beta %u lead %u\n",
+           (unsigned)TRACE_USE_DELAY_US, TRACE_NOISE, POSITION_FILTER_ALPHA, POSITION_FILTER_BETA,
+           POSITION_FILTER_LEAD);
+    printf("%-24s %6s %9s %9s %9s %9s\n", "trace", "frames", "raw rms", "raw max", "filt rms", "filt max");
+
+    for (i = 0; i < (int)count; i++)
+    {
+        run_trace(&traces[i], &total_raw, &total_filtered);
+    }
+
+    printf("%-24s %6u %9.2f %9.2f %9.2f %9.2f\n", "all", total_raw.frames,
+           rms(&total_raw), total_raw.max, rms(&total_filtered), total_filtered.max);
+
+    return sim_report("bench_position_filter");
+}
@@ -0,0 +1,18 @@
+#!/bin/sh
+# Usage: configure.sh <output> [OPTION=VALUE ...]
+# Copies ../main.c to <output> with the given user options changed, as they
+# would be edited in main.c. Fails if an option is not defined there.
+out=$1
+shift
+cp ../main.c "$out.tmp" || exit 1
+for opt in "$@"; do
+    name=${opt%%=*}
+    value=${opt#*=}
+    if ! grep -q "^#define $name  *([0-9]*u)" "$out.tmp"; then
+        echo "configure.sh: option $name not found in main.c" >&2
+        rm -f "$out.tmp"
+        exit 1
+    fi
+    sed -i "s/^#define $name\( *\)([0-9]*u)/#define $name\1($value)/" "$out.tmp"
+done
+mv "$out.tmp" "$out"
@@ -0,0 +1,94 @@
+/******************************************************************************
+* File Name: firmware_reset.h
+*
+* Description: Returns the model and the global state of the firmware in
+* main.c to their values at reset, so a test can run the firmware several
+* times in one program. Included after main.c, with the same user options.
+*
+*******************************************************************************/
+#ifndef FIRMWARE_RESET_H
+#define FIRMWARE_RESET_H
+
+#include <string.h>
+#include "sim.h"
+
+/* Resets the model with sim_reset() and the firmware globals. A test sets up
+ * its scenario after the call */
+static void firmware_reset(void)
+{
+    sim_reset();
+
+    #if (CY_CAPSENSE_GESTURE_EN)
+    gesture = 0u;
+    gestureHeldForLed = 0u;
+    led_delay = 0u;
+    clickIntervalTimer = 0u;
+    startDoubleClickTimer = 0u;
+    #endif
+
+    capsense_state = ACTIVE_MODE;
+    prev_capsense_state = ACTIVE_MODE;
+
+    #if ENABLE_POSITION_FILTER
+    memset(&position_filter, 0, sizeof(position_filter));
+    #endif
+
+    #if ENABLE_HOST_INTERFACE
+    memset((void *)&host_interface, 0, sizeof(host_interface));
+    #endif
+
+    #if ENABLE_GESTURE_EXTENSION
+    memset(&gesture_engine, 0, sizeof(gesture_engine));
+    #endif
+
+    #if ENABLE_ISR_LATENCY
+    cpu_wakeup_tick = 0u;
+    deep_sleep_exit_tick = 0u;
+    capsense_wakeup_pending = 0u;
+    ezi2c_wakeup_pending = 0u;
+    deep_sleep_exit_pending = 0u;
+    #endif
+
+    #if ENABLE_TOUCHPAD_SPECIALIZED_PROCESSING
+    memset(&touchpad_status, 0, sizeof(touchpad_status));
+    #endif
+
+    #if ENABLE_FRAME_JITTER
+    ezi2c_isr_count = 0u;
+    #endif
+
+    #if ENABLE_ILO_TIMEBASE
+    ilo_timebase_wraps = 0u;
+    scan_start_ilo_ticks = 0u;
+    #endif
+
+    #if (ENABLE_TELEMETRY && ENABLE_ILO_TIMEBASE)
+    wot_end_ilo_ticks = 0u;
+    #endif
+
+    #if ENABLE_SLEEP_MANAGER
+    ilo_ticks_per_ms = ILO_TICKS_PER_MS_NOMINAL;
+    #if (CY_CAPSENSE_GESTURE_EN && ENABLE_ILO_TIMEBASE)
+    gesture_deep_sleep_ticks = 0u;
+    #endif
+    #endif
+
+    #if ENABLE_IDLE_TASK_SCHEDULER
+    memset(idle_tasks, 0, sizeof(idle_tasks));
+    idle_task_count = 0u;
+    #endif
+
+    #if (ENABLE_RUN_TIME_MEASUREMENT || CY_CAPSENSE_GESTURE_EN)
+    frame_start_tick = 0u;
+    #endif
+
+    memset(&ezi2c_context, 0, sizeof(ezi2c_context));
+
+    #if (ENABLE_TUNER && ENABLE_TUNER_SNAPSHOT)
+    memset(tuner_snapshot, 0, sizeof(tuner_snapshot));
+    tuner_front = 0u;
+    tuner_write_count = 0u;
+    #endif
+}
+
+#endif /* FIRMWARE_RESET_H */
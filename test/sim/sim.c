@@ -0,0 +1,1472 @@
+/******************************************************************************
+* File Name: sim.c
+*
+* Description: Host model of the PSoC 4000T peripherals and of the CAPSENSE
+* middleware calls used by main.c. See sim.h.
+*
+*******************************************************************************/
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+#define SIM_EVENT_MAX                   (64u)
+#define SIM_IRQ_MAX                     (16u)
+#define SIM_EZI2C_OP_MAX                (64u)
+
+/* The SysTick exception is modeled as one more interrupt line */
+#define SIM_SYSTICK_IRQ                 (SIM_IRQ_MAX - 1)
+#define SIM_SYSTICK_PRIORITY            (3u)
+#define SIM_THREAD_PRIORITY             (4u)
+
+#define SIM_SYSPM_CALLBACK_MAX          (8u)
+
+typedef struct
+{
+    uint64_t time;
+    sim_event_fn fn;
+    void *arg;
+} sim_event_t;
+
+typedef struct
+{
+    cy_israddress isr;
+    uint32_t priority;
+    uint8_t enabled;
+    uint8_t pending;
+} sim_irq_t;
+
+typedef enum
+{
+    EZI2C_OP_START,
+    EZI2C_OP_WRITE,
+    EZI2C_OP_READ,
+    EZI2C_OP_STOP
+} sim_ezi2c_op_type_t;
+
+typedef struct
+{
+    sim_ezi2c_op_type_t type;
+    uint32_t buffer;
+    uint32_t offset;
+    uint8_t data[32];
+    uint8_t *ptrRead;
+    uint32_t size;
+} sim_ezi2c_op_t;
+
+/*******************************************************************************
+* Global Variables
+*******************************************************************************/
+void (*sim_sleep_hook)(void);
+void (*sim_critical_section_hook)(void);
+void (*sim_tuner_loop_hook)(void);
+sim_power_stats_t sim_power_stats;
+uint32_t sim_isr_overhead_cycles;
+uint32_t sim_ezi2c_isr_cycles;
+uint32_t sim_failures;
+uint32_t sim_ilo_freq;
+uint32_t sim_pwm_compare[SIM_PWM_COUNT];
+uint32_t (*sim_touch_source)(uint64_t time, sim_touch_t *touches);
+void (*sim_touchpad_diff_source)(uint64_t time, uint16_t *diffs);
+uint32_t (*sim_gesture_source)(uint64_t time);
+uint32_t sim_process_cycles;
+uint32_t sim_process_widget_cycles;
+uint32_t sim_process_status_cycles;
+uint32_t sim_gesture_cycles;
+uint32_t sim_tuner_cycles;
+uint32_t sim_capsense_isr_cycles;
+uint32_t sim_frame_count;
+uint32_t sim_wot_count;
+uint64_t sim_scan_start_time;
+uint64_t sim_scan_end_time;
+uint64_t sim_wot_start_time;
+uint64_t sim_wot_end_time;
+uint64_t sim_wot_cycles;
+
+static uint64_t now;
+static sim_event_t events[SIM_EVENT_MAX];
+static uint32_t event_count;
+
+static sim_irq_t irqs[SIM_IRQ_MAX];
+static uint32_t primask;
+static uint32_t current_priority;
+static uint32_t isr_taken;
+static uint64_t preempted_cycles;   /* Interrupt time in the current sim_advance() */
+static uint32_t deep_sleep;
+
+static uint32_t systick_running;
+static uint32_t systick_reload;
+static uint64_t systick_cycles;
+static Cy_SysTick_Callback systick_callback;
+
+static uint8_t *ezi2c_buf[3];
+static uint32_t ezi2c_size[3];
+static uint32_t ezi2c_rw_boundary[3];
+static uint32_t ezi2c_status;
+static uint32_t ezi2c_cur_buffer;
+static uint32_t ezi2c_cur_offset;
+static sim_ezi2c_op_t ezi2c_ops[SIM_EZI2C_OP_MAX];
+static uint32_t ezi2c_op_count;
+static uint32_t ezi2c_enabled;
+static uint32_t ezi2c_sleep_checked;
+
+static cy_stc_syspm_callback_t *syspm_callbacks[SIM_SYSPM_CALLBACK_MAX];
+static uint32_t syspm_callback_count;
+
+static jmp_buf run_exit;
+static uint64_t run_until;
+static uint32_t run_active;
+
+static uint32_t wdt_enabled;
+static uint64_t wdt_start;
+static uint32_t wdt_match;
+static uint32_t wdt_masked;
+static uint32_t wdt_unserviced;
+static uint32_t wdt_generation;
+
+static uint32_t msclp_timer_us;
+static uint32_t scan_busy;
+static uint32_t wot_scans;
+static uint32_t wot_touched;
+static uint32_t scan_generation;
+static sim_touch_t scan_touches[CY_CAPSENSE_TOUCHPAD_NUM_TOUCHES];
+static uint32_t scan_touch_count;
+static cy_stc_capsense_position_t touchpad_positions[CY_CAPSENSE_TOUCHPAD_NUM_TOUCHES];
+static uint16_t scan_diffs[CY_CAPSENSE_TOUCHPAD_NUM_SNS];
+static uint8_t touchpad_active;
+static uint8_t touchpad_debounce;
+
+/* Board resources */
+CySCB_Type sim_scb1;
+CySCB_Type *CYBSP_EZI2C_HW = &sim_scb1;
+const cy_stc_scb_ezi2c_config_t CYBSP_EZI2C_config;
+
+static TCPWM_Type sim_tcpwm;
+TCPWM_Type *CYBSP_PWM_0_HW = &sim_tcpwm;
+TCPWM_Type *CYBSP_PWM_1_HW = &sim_tcpwm;
+TCPWM_Type *CYBSP_PWM_2_HW = &sim_tcpwm;
+TCPWM_Type *CYBSP_PWM_3_HW = &sim_tcpwm;
+const cy_stc_tcpwm_pwm_config_t CYBSP_PWM_0_config = { .period0 = 255u };
+const cy_stc_tcpwm_pwm_config_t CYBSP_PWM_1_config = { .period0 = 255u };
+const cy_stc_tcpwm_pwm_config_t CYBSP_PWM_2_config = { .period0 = 255u };
+const cy_stc_tcpwm_pwm_config_t CYBSP_PWM_3_config = { .period0 = 255u };
+
+/* CAPSENSE data */
+cy_stc_capsense_tuner_t cy_capsense_tuner;
+static cy_stc_capsense_internal_context_t capsense_internal_context;
+static const cy_stc_capsense_widget_config_t widget_config_default[CY_CAPSENSE_TOTAL_WIDGET_COUNT] =
+{
+    {
+        .ptrWdContext = &cy_capsense_tuner.wdgtContext[CY_CAPSENSE_TOUCHPAD_WDGT_ID],
+        .ptrSnsContext = &cy_capsense_tuner.snsContext[CY_CAPSENSE_TOUCHPAD_SNS0_ID],
+        .numSns = CY_CAPSENSE_TOUCHPAD_NUM_SNS,
+        .numCols = CY_CAPSENSE_TOUCHPAD_NUM_COLS,
+        .numRows = CY_CAPSENSE_TOUCHPAD_NUM_ROWS,
+        .xResolution = CY_CAPSENSE_TOUCHPAD_MAX_POSITION,
+        .yResolution = CY_CAPSENSE_TOUCHPAD_MAX_POSITION,
+        /* As in design.cycapsense: 3 x 3 centroid with edge correction, no ballistic multiplier or position filter */
+        .centroidConfig = CY_CAPSENSE_CENTROID_3X3_MASK | CY_CAPSENSE_EDGE_CORRECTION_MASK,
+        .posFilterConfig = 0u,
+    },
+    {
+        .ptrWdContext = &cy_capsense_tuner.wdgtContext[CY_CAPSENSE_LOWPOWER0_WDGT_ID],
+        .ptrSnsContext = &cy_capsense_tuner.snsContext[CY_CAPSENSE_TOUCHPAD_NUM_SNS],
+        .numSns = 1u,
+    },
+};
+
+cy_stc_capsense_widget_config_t sim_widget_config[CY_CAPSENSE_TOTAL_WIDGET_COUNT];
+
+cy_stc_capsense_context_t cy_capsense_context =
+{
+    .ptrCommonContext = &cy_capsense_tuner.commonContext,
+    .ptrInternalContext = &capsense_internal_context,
+    .ptrWdConfig = sim_widget_config,
+};
+
+/*******************************************************************************
+* Virtual time and events
+*******************************************************************************/
+static void deliver_irqs(void);
+
+void sim_reset(void)
+{
+    now = 0u;
+    event_count = 0u;
+    memset(irqs, 0, sizeof(irqs));
+    irqs[SIM_SYSTICK_IRQ].priority = SIM_SYSTICK_PRIORITY;
+    primask = 1u;
+    current_priority = SIM_THREAD_PRIORITY;
+    isr_taken = 0u;
+    preempted_cycles = 0u;
+    deep_sleep = 0u;
+    systick_running = 0u;
+    systick_cycles = 0u;
+    systick_callback = NULL;
+    memset(ezi2c_buf, 0, sizeof(ezi2c_buf));
+    ezi2c_status = 0u;
+    ezi2c_op_count = 0u;
+    ezi2c_enabled = 0u;
+    syspm_callback_count = 0u;
+    memset(&sim_power_stats, 0, sizeof(sim_power_stats));
+    memset(&cy_capsense_tuner, 0, sizeof(cy_capsense_tuner));
+    memcpy(sim_widget_config, widget_config_default, sizeof(sim_widget_config));
+    memset(&capsense_internal_context, 0, sizeof(capsense_internal_context));
+    sim_sleep_hook = NULL;
+    sim_critical_section_hook = NULL;
+    sim_tuner_loop_hook = NULL;
+    sim_isr_overhead_cycles = 0u;
+    sim_ezi2c_isr_cycles = 0u;
+    run_active = 0u;
+    sim_ilo_freq = SIM_ILO_FREQ;
+    memset(sim_pwm_compare, 0, sizeof(sim_pwm_compare));
+    wdt_enabled = 0u;
+    wdt_match = 0u;
+    wdt_masked = 1u;
+    wdt_unserviced = 0u;
+    wdt_generation++;
+    msclp_timer_us = 0u;
+    scan_busy = 0u;
+    wot_touched = 0u;
+    scan_generation++;
+    scan_touch_count = 0u;
+    memset(scan_diffs, 0, sizeof(scan_diffs));
+    touchpad_active = 0u;
+    touchpad_debounce = 0u;
+    sim_touch_source = NULL;
+    sim_touchpad_diff_source = NULL;
+    sim_gesture_source = NULL;
+    sim_process_cycles = 0u;
+    sim_process_widget_cycles = 0u;
+    sim_process_status_cycles = 0u;
+    sim_gesture_cycles = 0u;
+    sim_tuner_cycles = 0u;
+    sim_capsense_isr_cycles = 0u;
+    sim_frame_count = 0u;
+    sim_wot_count = 0u;
+    sim_scan_start_time = 0u;
+    sim_scan_end_time = 0u;
+    sim_wot_start_time = 0u;
+    sim_wot_end_time = 0u;
+    sim_wot_cycles = 0u;
+}
+
+void sim_run(int (*entry)(void), uint64_t until)
+{
+    run_until = until;
+    run_active = 1u;
+    if (0 == setjmp(run_exit))
+    {
+        (void)entry();
+    }
+    run_active = 0u;
+
+    /* The firmware is stopped in a critical section, the interrupts are enabled
+     * again so the test can act as the host */
+    __enable_irq();
+}
+
+uint64_t sim_now(void)
+{
+    return now;
+}
+
+void sim_schedule(uint64_t time, sim_event_fn fn, void *arg)
+{
+    uint32_t i = event_count;
+
+    if (event_count >= SIM_EVENT_MAX)
+    {
+        fprintf(stderr, "sim: event queue full\n");
+        exit(2);
+    }
+
+    /* Kept sorted by time, events at the same time run in the scheduling order */
+    while ((i > 0u) && (events[i - 1u].time > time))
+    {
+        events[i] = events[i - 1u];
+        i--;
+    }
+    events[i].time = time;
+    events[i].fn = fn;
+    events[i].arg = arg;
+    event_count++;
+}
+
+/* Time of the next SysTick interrupt, or UINT64_MAX if it cannot occur */
+static uint64_t next_systick_time(void)
+{
+    uint64_t period = (uint64_t)systick_reload + 1u;
+
+    if ((0u == systick_running) || (0u != deep_sleep))
+    {
+        return UINT64_MAX;
+    }
+    return now + (period - (systick_cycles % period));
+}
+
+static void move_time(uint64_t time)
+{
+    if ((0u != systick_running) && (0u == deep_sleep))
+    {
+        systick_cycles += time - now;
+    }
+    now = time;
+}
+
+void sim_advance(uint64_t cycles)
+{
+    uint64_t target = now + cycles;
+    uint64_t saved_preempted = preempted_cycles;
+    uint64_t tick;
+    sim_event_t event;
+    uint32_t i;
+
+    /* The interrupts taken meanwhile delay the end by their execution time */
+    preempted_cycles = 0u;
+
+    for (;;)
+    {
+        tick = next_systick_time();
+
+        if ((event_count > 0u) && (events[0].time <= target) && (events[0].time <= tick))
+        {
+            event = events[0];
+            event_count--;
+            for (i = 0u; i < event_count; i++)
+            {
+                events[i] = events[i + 1u];
+            }
+            move_time(event.time);
+            event.fn(event.arg);
+            deliver_irqs();
+        }
+        else if (tick <= target)
+        {
+            move_time(tick);
+            sim_raise_irq(SIM_SYSTICK_IRQ);
+        }
+        else
+        {
+            break;
+        }
+        target += preempted_cycles;
+        preempted_cycles = 0u;
+    }
+    move_time(target);
+    preempted_cycles = saved_preempted;
+}
+
+/*******************************************************************************
+* Interrupts
+*******************************************************************************/
+static void deliver_irqs(void)
+{
+    uint32_t i;
+    uint32_t best;
+    uint32_t saved;
+    uint64_t start;
+
+    while (0u == primask)
+    {
+        best = SIM_IRQ_MAX;
+        for (i = 0u; i < SIM_IRQ_MAX; i++)
+        {
+            if ((0u != irqs[i].pending) && (0u != irqs[i].enabled) && (irqs[i].priority < current_priority) &&
+                ((SIM_IRQ_MAX == best) || (irqs[i].priority < irqs[best].priority)))
+            {
+                best = i;
+            }
+        }
+        if (SIM_IRQ_MAX == best)
+        {
+            break;
+        }
+
+        irqs[best].pending = 0u;
+        saved = current_priority;
+        current_priority = irqs[best].priority;
+        isr_taken++;
+        start = now;
+        sim_advance(sim_isr_overhead_cycles);
+        if (NULL != irqs[best].isr)
+        {
+            irqs[best].isr();
+        }
+        preempted_cycles += now - start;
+        current_priority = saved;
+    }
+}
+
+void sim_raise_irq(IRQn_Type irq)
+{
+    irqs[irq].pending = 1u;
+    deliver_irqs();
+}
+
+int Cy_SysInt_Init(const cy_stc_sysint_t *config, cy_israddress userIsr)
+{
+    irqs[config->intrSrc].isr = userIsr;
+    irqs[config->intrSrc].priority = config->intrPriority;
+    return 0;
+}
+
+void NVIC_EnableIRQ(IRQn_Type irq)
+{
+    irqs[irq].enabled = 1u;
+    deliver_irqs();
+}
+
+void NVIC_DisableIRQ(IRQn_Type irq)
+{
+    irqs[irq].enabled = 0u;
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type irq)
+{
+    irqs[irq].pending = 0u;
+}
+
+uint32_t NVIC_GetPendingIRQ(IRQn_Type irq)
+{
+    return irqs[irq].pending;
+}
+
+void __enable_irq(void)
+{
+    primask = 0u;
+    deliver_irqs();
+}
+
+void __disable_irq(void)
+{
+    primask = 1u;
+}
+
+uint32_t Cy_SysLib_EnterCriticalSection(void)
+{
+    uint32_t saved;
+
+    if (NULL != sim_critical_section_hook)
+    {
+        sim_critical_section_hook();
+    }
+    saved = primask;
+    primask = 1u;
+    return saved;
+}
+
+void Cy_SysLib_ExitCriticalSection(uint32_t savedIntrStatus)
+{
+    primask = savedIntrStatus;
+    deliver_irqs();
+}
+
+void Cy_SysLib_Delay(uint32_t milliseconds)
+{
+    sim_advance(SIM_US(milliseconds * 1000u));
+}
+
+/*******************************************************************************
+* System power management
+*******************************************************************************/
+/* Runs until an enabled interrupt is pending, also when masked, as WFI does */
+static void wait_for_interrupt(void)
+{
+    uint32_t taken = isr_taken;
+    uint64_t tick;
+    uint64_t next;
+    uint32_t i;
+
+    if (NULL != sim_sleep_hook)
+    {
+        sim_sleep_hook();
+    }
+
+    if ((0u != run_active) && (now >= run_until))
+    {
+        longjmp(run_exit, 1);
+    }
+
+    for (;;)
+    {
+        for (i = 0u; i < SIM_IRQ_MAX; i++)
+        {
+            if ((0u != irqs[i].pending) && (0u != irqs[i].enabled))
+            {
+                return;
+            }
+        }
+        if (taken != isr_taken)
+        {
+            return;
+        }
+
+        tick = next_systick_time();
+        next = (event_count > 0u) ? CY_MIN(events[0].time, tick) : tick;
+        if (UINT64_MAX == next)
+        {
+            fprintf(stderr, "sim: CPU sleeps with no wake-up source\n");
+            exit(2);
+        }
+        sim_advance(next - now);
+    }
+}
+
+static uint32_t run_syspm_callbacks(cy_en_syspm_callback_type_t type, cy_en_syspm_callback_mode_t mode,
+                                    uint32_t count)
+{
+    uint32_t i;
+    cy_stc_syspm_callback_t *ptrCb;
+
+    for (i = 0u; i < count; i++)
+    {
+        ptrCb = syspm_callbacks[i];
+        if ((ptrCb->type == type) && (0u == (ptrCb->skipMode & (uint32_t)mode)))
+        {
+            if (CY_SYSPM_SUCCESS != ptrCb->callback(ptrCb->callbackParams, mode))
+            {
+                return i;
+            }
+        }
+    }
+    return count;
+}
+
+bool Cy_SysPm_RegisterCallback(cy_stc_syspm_callback_t *handler)
+{
+    if (syspm_callback_count >= SIM_SYSPM_CALLBACK_MAX)
+    {
+        return false;
+    }
+    syspm_callbacks[syspm_callback_count++] = handler;
+    return true;
+}
+
+bool Cy_SysPm_UnregisterCallback(cy_stc_syspm_callback_t const *handler)
+{
+    (void)handler;
+    return false;
+}
+
+cy_en_syspm_status_t Cy_SysPm_CpuEnterSleep(void)
+{
+    uint64_t start = now;
+
+    sim_power_stats.sleepCount++;
+    wait_for_interrupt();
+    sim_power_stats.sleepCycles += now - start;
+    return CY_SYSPM_SUCCESS;
+}
+
+cy_en_syspm_status_t Cy_SysPm_CpuEnterDeepSleep(void)
+{
+    uint64_t start;
+    uint32_t failed;
+
+    ezi2c_sleep_checked = 0u;
+    failed = run_syspm_callbacks(CY_SYSPM_DEEPSLEEP, CY_SYSPM_CHECK_READY, syspm_callback_count);
+    if (failed != syspm_callback_count)
+    {
+        (void)run_syspm_callbacks(CY_SYSPM_DEEPSLEEP, CY_SYSPM_CHECK_FAIL, failed);
+        return CY_SYSPM_FAIL;
+    }
+
+    /* Without its callback the EZI2C slave can be cut off in the middle of a transaction */
+    if ((0u != ezi2c_enabled) && (0u == ezi2c_sleep_checked))
+    {
+        fprintf(stderr, "sim: Deep Sleep with the EZI2C enabled and no EZI2C Deep Sleep callback\n");
+        exit(2);
+    }
+    (void)run_syspm_callbacks(CY_SYSPM_DEEPSLEEP, CY_SYSPM_BEFORE_TRANSITION, syspm_callback_count);
+
+    start = now;
+    sim_power_stats.deepSleepCount++;
+    deep_sleep = 1u;
+    wait_for_interrupt();
+    deep_sleep = 0u;
+    sim_power_stats.deepSleepCycles += now - start;
+
+    (void)run_syspm_callbacks(CY_SYSPM_DEEPSLEEP, CY_SYSPM_AFTER_TRANSITION, syspm_callback_count);
+    return CY_SYSPM_SUCCESS;
+}
+
+/*******************************************************************************
+* SysTick
+*******************************************************************************/
+static void systick_isr(void)
+{
+    if (NULL != systick_callback)
+    {
+        systick_callback();
+    }
+}
+
+void Cy_SysTick_Init(uint32_t clockSource, uint32_t interval)
+{
+    (void)clockSource;
+    systick_reload = interval & 0x00FFFFFFu;
+    systick_cycles = 0u;
+    systick_running = 1u;
+    irqs[SIM_SYSTICK_IRQ].isr = systick_isr;
+    irqs[SIM_SYSTICK_IRQ].enabled = 1u;
+}
+
+void Cy_SysTick_SetCallback(uint32_t number, Cy_SysTick_Callback function)
+{
+    (void)number;
+    systick_callback = function;
+}
+
+void Cy_SysTick_Clear(void)
+{
+    uint64_t period = (uint64_t)systick_reload + 1u;
+
+    systick_cycles -= systick_cycles % period;
+}
+
+uint32_t Cy_SysTick_GetValue(void)
+{
+    return systick_reload - (uint32_t)(systick_cycles % ((uint64_t)systick_reload + 1u));
+}
+
+/*******************************************************************************
+* EZI2C slave
+*******************************************************************************/
+cy_en_scb_ezi2c_status_t Cy_SCB_EZI2C_Init(CySCB_Type *base, cy_stc_scb_ezi2c_config_t const *config,
+                                           cy_stc_scb_ezi2c_context_t *context)
+{
+    (void)base;
+    (void)config;
+    (void)context;
+    return CY_SCB_EZI2C_SUCCESS;
+}
+
+void Cy_SCB_EZI2C_Enable(CySCB_Type *base)
+{
+    (void)base;
+    ezi2c_enabled = 1u;
+}
+
+void Cy_SCB_EZI2C_SetBuffer1(CySCB_Type const *base, uint8_t *buffer, uint32_t size, uint32_t rwBoundary,
+                             cy_stc_scb_ezi2c_context_t *context)
+{
+    (void)base;
+    context->buf1 = buffer;
+    ezi2c_buf[SIM_EZI2C_BUFFER1] = buffer;
+    ezi2c_size[SIM_EZI2C_BUFFER1] = size;
+    ezi2c_rw_boundary[SIM_EZI2C_BUFFER1] = rwBoundary;
+}
+
+void Cy_SCB_EZI2C_SetBuffer2(CySCB_Type const *base, uint8_t *buffer, uint32_t size, uint32_t rwBoundary,
+                             cy_stc_scb_ezi2c_context_t *context)
+{
+    (void)base;
+    (void)context;
+    ezi2c_buf[SIM_EZI2C_BUFFER2] = buffer;
+    ezi2c_size[SIM_EZI2C_BUFFER2] = size;
+    ezi2c_rw_boundary[SIM_EZI2C_BUFFER2] = rwBoundary;
+}
+
+uint32_t Cy_SCB_EZI2C_GetActivity(CySCB_Type const *base, cy_stc_scb_ezi2c_context_t *context)
+{
+    uint32_t status = ezi2c_status;
+
+    (void)base;
+    (void)context;
+
+    /* All the flags but the busy one are cleared on read */
+    ezi2c_status &= CY_SCB_EZI2C_STATUS_BUSY;
+    return status;
+}
+
+/* The bus data is moved between the FIFO and the buffers by the interrupt, as in
+ * the driver. A stop ends the interrupt, so the status and the context after a
+ * completed transaction are seen by the caller before the next one starts */
+void Cy_SCB_EZI2C_Interrupt(CySCB_Type *base, cy_stc_scb_ezi2c_context_t *context)
+{
+    sim_ezi2c_op_t *ptrOp;
+    uint32_t i;
+    uint32_t index;
+
+    (void)base;
+
+    sim_advance(sim_ezi2c_isr_cycles);
+
+    for (i = 0u; i < ezi2c_op_count; i++)
+    {
+        ptrOp = &ezi2c_ops[i];
+        switch (ptrOp->type)
+        {
+            case EZI2C_OP_START:
+                ezi2c_status |= CY_SCB_EZI2C_STATUS_BUSY;
+                ezi2c_cur_buffer = ptrOp->buffer;
+                ezi2c_cur_offset = ptrOp->offset;
+                if (SIM_EZI2C_BUFFER1 == ptrOp->buffer)
+                {
+                    context->baseAddr1 = ptrOp->offset;
+                }
+                context->curBuf = ezi2c_buf[ezi2c_cur_buffer] + ptrOp->offset;
+                break;
+
+            case EZI2C_OP_WRITE:
+                for (index = 0u; index < ptrOp->size; index++)
+                {
+                    /* The bytes past the read/write boundary are not written */
+                    if (ezi2c_cur_offset < ezi2c_rw_boundary[ezi2c_cur_buffer])
+                    {
+                        ezi2c_buf[ezi2c_cur_buffer][ezi2c_cur_offset] = ptrOp->data[index];
+                        context->curBuf++;
+                    }
+                    ezi2c_cur_offset++;
+                }
+                break;
+
+            case EZI2C_OP_READ:
+                for (index = 0u; index < ptrOp->size; index++)
+                {
+                    ptrOp->ptrRead[index] = (ezi2c_cur_offset < ezi2c_size[ezi2c_cur_buffer]) ?
+                                            ezi2c_buf[ezi2c_cur_buffer][ezi2c_cur_offset] : 0xFFu;
+                    ezi2c_cur_offset++;
+                }
+                break;
+
+            default:
+                ezi2c_status &= ~CY_SCB_EZI2C_STATUS_BUSY;
+                if (SIM_EZI2C_BUFFER1 == ezi2c_cur_buffer)
+                {
+                    ezi2c_status |= (0u != ptrOp->size) ? CY_SCB_EZI2C_STATUS_WRITE1 : CY_SCB_EZI2C_STATUS_READ1;
+                }
+                else
+                {
+                    ezi2c_status |= (0u != ptrOp->size) ? CY_SCB_EZI2C_STATUS_WRITE2 : CY_SCB_EZI2C_STATUS_READ2;
+                }
+
+                if ((i + 1u) < ezi2c_op_count)
+                {
+                    memmove(ezi2c_ops, &ezi2c_ops[i + 1u], (ezi2c_op_count - i - 1u) * sizeof(ezi2c_ops[0]));
+                    ezi2c_op_count -= i + 1u;
+                    sim_raise_irq(CYBSP_EZI2C_IRQ);
+                    return;
+                }
+                break;
+        }
+    }
+    ezi2c_op_count = 0u;
+}
+
+cy_en_syspm_status_t Cy_SCB_EZI2C_DeepSleepCallback(cy_stc_syspm_callback_params_t *callbackParams,
+                                                    cy_en_syspm_callback_mode_t mode)
+{
+    (void)callbackParams;
+
+    if (CY_SYSPM_CHECK_READY == mode)
+    {
+        ezi2c_sleep_checked = 1u;
+    }
+
+    /* The driver rejects Deep Sleep during a transaction */
+    if ((CY_SYSPM_CHECK_READY == mode) && (0u != (ezi2c_status & CY_SCB_EZI2C_STATUS_BUSY)))
+    {
+        return CY_SYSPM_FAIL;
+    }
+    return CY_SYSPM_SUCCESS;
+}
+
+static sim_ezi2c_op_t *add_ezi2c_op(sim_ezi2c_op_type_t type)
+{
+    sim_ezi2c_op_t *ptrOp;
+
+    if (ezi2c_op_count >= SIM_EZI2C_OP_MAX)
+    {
+        fprintf(stderr, "sim: EZI2C FIFO overflow\n");
+        exit(2);
+    }
+    ptrOp = &ezi2c_ops[ezi2c_op_count++];
+    ptrOp->type = type;
+    ptrOp->size = 0u;
+    return ptrOp;
+}
+
+static uint32_t ezi2c_write_pending;
+
+void sim_ezi2c_start(uint32_t buffer, uint32_t write, uint32_t offset)
+{
+    sim_ezi2c_op_t *ptrOp = add_ezi2c_op(EZI2C_OP_START);
+
+    ptrOp->buffer = buffer;
+    ptrOp->offset = offset;
+    ezi2c_write_pending = write;
+    sim_raise_irq(CYBSP_EZI2C_IRQ);
+}
+
+void sim_ezi2c_write(const void *data, uint32_t size)
+{
+    const uint8_t *ptrData = (const uint8_t *)data;
+    sim_ezi2c_op_t *ptrOp;
+    uint32_t chunk;
+
+    while (size > 0u)
+    {
+        chunk = CY_MIN(size, (uint32_t)sizeof(ptrOp->data));
+        ptrOp = add_ezi2c_op(EZI2C_OP_WRITE);
+        memcpy(ptrOp->data, ptrData, chunk);
+        ptrOp->size = chunk;
+        ptrData += chunk;
+        size -= chunk;
+    }
+    sim_raise_irq(CYBSP_EZI2C_IRQ);
+}
+
+void sim_ezi2c_read(void *data, uint32_t size)
+{
+    sim_ezi2c_op_t *ptrOp = add_ezi2c_op(EZI2C_OP_READ);
+
+    ptrOp->ptrRead = (uint8_t *)data;
+    ptrOp->size = size;
+    sim_raise_irq(CYBSP_EZI2C_IRQ);
+}
+
+void sim_ezi2c_stop(void)
+{
+    sim_ezi2c_op_t *ptrOp = add_ezi2c_op(EZI2C_OP_STOP);
+
+    /* The size of a stop holds the direction of the transaction */
+    ptrOp->size = ezi2c_write_pending;
+    sim_raise_irq(CYBSP_EZI2C_IRQ);
+}
+
+void sim_host_write(uint32_t buffer, uint32_t offset, const void *data, uint32_t size)
+{
+    sim_ezi2c_start(buffer, 1u, offset);
+    sim_ezi2c_write(data, size);
+    sim_ezi2c_stop();
+}
+
+void sim_host_read(uint32_t buffer, uint32_t offset, void *data, uint32_t size)
+{
+    sim_ezi2c_start(buffer, 0u, offset);
+    sim_ezi2c_read(data, size);
+    sim_ezi2c_stop();
+}
+
+uint8_t *sim_ezi2c_buffer(uint32_t buffer)
+{
+    return ezi2c_buf[buffer];
+}
+
+uint32_t sim_ezi2c_buffer_size(uint32_t buffer)
+{
+    return ezi2c_size[buffer];
+}
+
+/*******************************************************************************
+* Board and PWM
+*******************************************************************************/
+cy_rslt_t cybsp_init(void)
+{
+    return CY_RSLT_SUCCESS;
+}
+
+uint32_t Cy_TCPWM_PWM_Init(TCPWM_Type *base, uint32_t cntNum, cy_stc_tcpwm_pwm_config_t const *config)
+{
+    (void)base;
+    (void)cntNum;
+    (void)config;
+    return 0u;
+}
+
+void Cy_TCPWM_Enable_Multiple(TCPWM_Type *base, uint32_t counters)
+{
+    (void)base;
+    (void)counters;
+}
+
+void Cy_TCPWM_TriggerReloadOrIndex(TCPWM_Type *base, uint32_t counters)
+{
+    (void)base;
+    (void)counters;
+}
+
+void Cy_TCPWM_PWM_SetCompare0(TCPWM_Type *base, uint32_t cntNum, uint32_t compare0)
+{
+    (void)base;
+    if (cntNum < SIM_PWM_COUNT)
+    {
+        sim_pwm_compare[cntNum] = compare0;
+    }
+}
+
+uint32_t Cy_TCPWM_PWM_GetCompare0(TCPWM_Type const *base, uint32_t cntNum)
+{
+    (void)base;
+    return (cntNum < SIM_PWM_COUNT) ? sim_pwm_compare[cntNum] : 0u;
+}
+
+/*******************************************************************************
+* Watchdog timer
+*******************************************************************************/
+static uint64_t ilo_ticks(void)
+{
+    return ((now - wdt_start) * sim_ilo_freq) / CY_CAPSENSE_CPU_CLK;
+}
+
+static void wdt_schedule(void);
+
+static void wdt_match_event(void *arg)
+{
+    if ((uintptr_t)arg != wdt_generation)
+    {
+        return;
+    }
+    if (0u == wdt_masked)
+    {
+        /* The WDT resets the device on the third match with the interrupt not cleared */
+        if (++wdt_unserviced >= 3u)
+        {
+            fprintf(stderr, "sim: watchdog reset\n");
+            sim_failures++;
+        }
+        sim_raise_irq(srss_interrupt_wdt_IRQn);
+    }
+    wdt_schedule();
+}
+
+static void wdt_schedule(void)
+{
+    uint64_t ticks = ilo_ticks() + 1u;
+    uint64_t period = 0x10000u;
+
+    /* Next tick at which the 16-bit count equals the match */
+    ticks += (wdt_match - (ticks % period) + period) % period;
+    sim_schedule(wdt_start + ((ticks * CY_CAPSENSE_CPU_CLK) + sim_ilo_freq - 1u) / sim_ilo_freq,
+                 wdt_match_event, (void *)(uintptr_t)wdt_generation);
+}
+
+void Cy_WDT_Enable(void)
+{
+    wdt_enabled = 1u;
+    wdt_start = now;
+    wdt_generation++;
+    wdt_schedule();
+}
+
+void Cy_WDT_Disable(void)
+{
+    wdt_enabled = 0u;
+    wdt_generation++;
+}
+
+void Cy_WDT_SetMatch(uint32_t match)
+{
+    wdt_match = match & 0xFFFFu;
+    if (0u != wdt_enabled)
+    {
+        wdt_generation++;
+        wdt_schedule();
+    }
+}
+
+uint32_t Cy_WDT_GetMatch(void)
+{
+    return wdt_match;
+}
+
+uint32_t sim_wdt_is_enabled(void)
+{
+    return wdt_enabled;
+}
+
+uint32_t Cy_WDT_GetCount(void)
+{
+    return (0u != wdt_enabled) ? (uint32_t)(ilo_ticks() & 0xFFFFu) : 0u;
+}
+
+void Cy_WDT_ClearInterrupt(void)
+{
+    wdt_unserviced = 0u;
+    irqs[srss_interrupt_wdt_IRQn].pending = 0u;
+}
+
+void Cy_WDT_MaskInterrupt(void)
+{
+    wdt_masked = 1u;
+}
+
+void Cy_WDT_UnmaskInterrupt(void)
+{
+    wdt_masked = 0u;
+}
+
+/*******************************************************************************
+* CAPSENSE middleware
+*******************************************************************************/
+static void scan_done_event(void *arg)
+{
+    if ((uintptr_t)arg != scan_generation)
+    {
+        return;
+    }
+    scan_touch_count = (NULL != sim_touch_source) ? sim_touch_source(now, scan_touches) : 0u;
+    if (NULL != sim_touchpad_diff_source)
+    {
+        sim_touchpad_diff_source(now, scan_diffs);
+    }
+    sim_scan_end_time = now;
+    sim_frame_count++;
+    sim_raise_irq(CY_MSCLP0_LP_IRQ);
+}
+
+static void wot_scan_event(void *arg)
+{
+    sim_touch_t touches[CY_CAPSENSE_TOUCHPAD_NUM_TOUCHES];
+
+    if ((uintptr_t)arg != scan_generation)
+    {
+        return;
+    }
+    wot_scans++;
+    wot_touched = ((NULL != sim_touch_source) && (0u != sim_touch_source(now, touches))) ? 1u : 0u;
+
+    if ((0u != wot_touched) || (wot_scans >= SIM_WOT_TIMEOUT_SCANS))
+    {
+        sim_wot_end_time = now;
+        sim_wot_cycles += now - sim_wot_start_time;
+        sim_raise_irq(CY_MSCLP0_LP_IRQ);
+    }
+    else
+    {
+        sim_schedule(now + SIM_US(SIM_WOT_SCAN_INTERVAL_US), wot_scan_event, arg);
+    }
+}
+
+cy_capsense_status_t Cy_CapSense_Init(cy_stc_capsense_context_t *context)
+{
+    cy_stc_capsense_widget_context_t *ptrWd;
+    uint32_t i;
+
+    /* As the middleware, the initialization clears the registered callbacks */
+    memset(context->ptrInternalContext, 0, sizeof(*context->ptrInternalContext));
+
+    for (i = 0u; i < CY_CAPSENSE_TOUCHPAD_NUM_TOUCHES; i++)
+    {
+        touchpad_positions[i].id = (uint16_t)i;
+    }
+    ptrWd = &cy_capsense_tuner.wdgtContext[CY_CAPSENSE_TOUCHPAD_WDGT_ID];
+    ptrWd->wdTouch.ptrPosition = touchpad_positions;
+    ptrWd->fingerTh = CY_CAPSENSE_TOUCHPAD_FINGER_TH;
+    ptrWd->hysteresis = CY_CAPSENSE_TOUCHPAD_HYSTERESIS;
+    ptrWd->onDebounce = CY_CAPSENSE_TOUCHPAD_ON_DEBOUNCE;
+    return CY_CAPSENSE_STATUS_SUCCESS;
+}
+
+cy_capsense_status_t Cy_CapSense_Enable(cy_stc_capsense_context_t *context)
+{
+    context->ptrCommonContext->initDone = 1u;
+    return CY_CAPSENSE_STATUS_SUCCESS;
+}
+
+void Cy_CapSense_InterruptHandler(void *base, cy_stc_capsense_context_t *context)
+{
+    (void)base;
+    (void)context;
+    sim_advance(sim_capsense_isr_cycles);
+    scan_busy = 0u;
+}
+
+void Cy_CapSense_IloCompensate(cy_stc_capsense_context_t *context)
+{
+    (void)context;
+}
+
+cy_capsense_status_t Cy_CapSense_ConfigureMsclpTimer(uint32_t wakeupTimer, cy_stc_capsense_context_t *context)
+{
+    (void)context;
+    msclp_timer_us = wakeupTimer;
+    return CY_CAPSENSE_STATUS_SUCCESS;
+}
+
+/* The frame scan starts when the MSCLP wake-up timer expires, the timer starts with the call */
+cy_capsense_status_t Cy_CapSense_ScanAllSlots(cy_stc_capsense_context_t *context)
+{
+    (void)context;
+    scan_busy = 1u;
+    scan_generation++;
+    sim_scan_start_time = now;
+    sim_schedule(now + SIM_US(msclp_timer_us + SIM_SCAN_TIME_US), scan_done_event,
+                 (void *)(uintptr_t)scan_generation);
+    return CY_CAPSENSE_STATUS_SUCCESS;
+}
+
+/* The low power widget is scanned every SIM_WOT_SCAN_INTERVAL_US until a touch or the timeout */
+cy_capsense_status_t Cy_CapSense_ScanAllLpSlots(cy_stc_capsense_context_t *context)
+{
+    (void)context;
+    scan_busy = 1u;
+    scan_generation++;
+    wot_scans = 0u;
+    wot_touched = 0u;
+    sim_wot_count++;
+    sim_wot_start_time = now;
+    sim_schedule(now + SIM_US(SIM_WOT_SCAN_INTERVAL_US), wot_scan_event, (void *)(uintptr_t)scan_generation);
+    return CY_CAPSENSE_STATUS_SUCCESS;
+}
+
+uint32_t Cy_CapSense_IsBusy(const cy_stc_capsense_context_t *context)
+{
+    (void)context;
+    return scan_busy;
+}
+
+/* Touches passed through as the touchpad positions */
+static void report_touches(void)
+{
+    cy_stc_capsense_widget_context_t *ptrWd = &cy_capsense_tuner.wdgtContext[CY_CAPSENSE_TOUCHPAD_WDGT_ID];
+    uint32_t i;
+
+    for (i = 0u; i < scan_touch_count; i++)
+    {
+        touchpad_positions[i].x = scan_touches[i].x;
+        touchpad_positions[i].y = scan_touches[i].y;
+        touchpad_positions[i].z = scan_touches[i].z;
+        touchpad_positions[i].id = (uint16_t)i;
+    }
+    ptrWd->wdTouch.numPosition = (uint8_t)scan_touch_count;
+    ptrWd->status = (0u != scan_touch_count) ? 1u : 0u;
+}
+
+/* Difference count of a node of the widget, zero outside of it */
+static int32_t node_diff(const cy_stc_capsense_widget_config_t *ptrWdCfg, int32_t col, int32_t row)
+{
+    if ((col < 0) || (row < 0) || (col >= (int32_t)ptrWdCfg->numCols) || (row >= (int32_t)ptrWdCfg->numRows))
+    {
+        return 0;
+    }
+    return ptrWdCfg->ptrSnsContext[(col * ptrWdCfg->numRows) + row].diff;
+}
+
+/* Generic CSX touchpad status model, driven by the widget configuration: local
+ * maxima of the difference counts above the finger threshold with hysteresis,
+ * the strongest kept, 3 x 3 centroid scaled to the resolution, on debounce */
+static void process_touchpad_status(void)
+{
+    const cy_stc_capsense_widget_config_t *ptrWdCfg = &sim_widget_config[CY_CAPSENSE_TOUCHPAD_WDGT_ID];
+    cy_stc_capsense_widget_context_t *ptrWd = ptrWdCfg->ptrWdContext;
+    int32_t peak[CY_CAPSENSE_TOUCHPAD_NUM_TOUCHES];
+    int32_t peakCol[CY_CAPSENSE_TOUCHPAD_NUM_TOUCHES];
+    int32_t peakRow[CY_CAPSENSE_TOUCHPAD_NUM_TOUCHES];
+    int32_t threshold;
+    int32_t col;
+    int32_t row;
+    int32_t dc;
+    int32_t dr;
+    int32_t d;
+    int32_t n;
+    int32_t x;
+    int32_t y;
+    int32_t sum;
+    int32_t span;
+    uint32_t count = 0u;
+    uint32_t i;
+    uint32_t local_max;
+
+    if (NULL == sim_touchpad_diff_source)
+    {
+        report_touches();
+        return;
+    }
+
+    threshold = (int32_t)ptrWd->fingerTh + ((0u != touchpad_active) ? -(int32_t)ptrWd->hysteresis : (int32_t)ptrWd->hysteresis);
+
+    for (col = 0; col < (int32_t)ptrWdCfg->numCols; col++)
+    {
+        for (row = 0; row < (int32_t)ptrWdCfg->numRows; row++)
+        {
+            d = node_diff(ptrWdCfg, col, row);
+            local_max = (d >= threshold) ? 1u : 0u;
+
+            for (dc = -1; (dc <= 1) && (0u != local_max); dc++)
+            {
+                for (dr = -1; dr <= 1; dr++)
+                {
+                    if ((0 == dc) && (0 == dr))
+                    {
+                        continue;
+                    }
+                    n = node_diff(ptrWdCfg, col + dc, row + dr);
+                    /* The nodes before in the sensor order win a tie */
+                    if ((((dc < 0) || ((0 == dc) && (dr < 0))) && (d <= n)) || (d < n))
+                    {
+                        local_max = 0u;
+                    }
+                }
+            }
+            if (0u == local_max)
+            {
+                continue;
+            }
+
+            /* Sorted by decreasing difference count */
+            i = count;
+            while ((i > 0u) && (d > peak[i - 1u]))
+            {
+                i--;
+            }
+            if (i < CY_CAPSENSE_TOUCHPAD_NUM_TOUCHES)
+            {
+                count = (count < CY_CAPSENSE_TOUCHPAD_NUM_TOUCHES) ? (count + 1u) : count;
+                memmove(&peak[i + 1u], &peak[i], (count - 1u - i) * sizeof(peak[0]));
+                memmove(&peakCol[i + 1u], &peakCol[i], (count - 1u - i) * sizeof(peakCol[0]));
+                memmove(&peakRow[i + 1u], &peakRow[i], (count - 1u - i) * sizeof(peakRow[0]));
+                peak[i] = d;
+                peakCol[i] = col;
+                peakRow[i] = row;
+            }
+        }
+    }
+
+    if (0u == count)
+    {
+        touchpad_debounce = 0u;
+        touchpad_active = 0u;
+    }
+    else
+    {
+        touchpad_debounce = (uint8_t)CY_MIN((uint32_t)touchpad_debounce + 1u, ptrWd->onDebounce);
+        touchpad_active = (touchpad_debounce >= ptrWd->onDebounce) ? 1u : touchpad_active;
+    }
+
+    ptrWd->wdTouch.numPosition = (0u != touchpad_active) ? (uint8_t)count : 0u;
+    ptrWd->status = (uint8_t)((ptrWd->status & ~CY_CAPSENSE_WD_ACTIVE_MASK) | touchpad_active);
+
+    for (i = 0u; i < ptrWd->wdTouch.numPosition; i++)
+    {
+        sum = 0;
+        x = 0;
+        y = 0;
+        for (dc = -1; dc <= 1; dc++)
+        {
+            for (dr = -1; dr <= 1; dr++)
+            {
+                n = node_diff(ptrWdCfg, peakCol[i] + dc, peakRow[i] + dr);
+                sum += n;
+                x += dc * n;
+                y += dr * n;
+            }
+        }
+
+        span = ((int32_t)ptrWdCfg->numCols - 1) * 256;
+        x = (peakCol[i] * 256) + ((x * 256) / sum);
+        x = CY_MIN(CY_MAX(x, 0), span);
+        touchpad_positions[i].x = (uint16_t)(((x * (int32_t)ptrWdCfg->xResolution) + (span / 2)) / span);
+
+        span = ((int32_t)ptrWdCfg->numRows - 1) * 256;
+        y = (peakRow[i] * 256) + ((y * 256) / sum);
+        y = CY_MIN(CY_MAX(y, 0), span);
+        touchpad_positions[i].y = (uint16_t)(((y * (int32_t)ptrWdCfg->yResolution) + (span / 2)) / span);
+
+        touchpad_positions[i].z = (uint16_t)CY_MIN(sum, UINT16_MAX);
+        touchpad_positions[i].id = (uint16_t)i;
+    }
+}
+
+/* Filters, baseline and difference counts: the difference counts of the scan are reported as they are */
+static void process_touchpad_raw_counts(void)
+{
+    uint32_t i;
+
+    for (i = 0u; i < CY_CAPSENSE_TOUCHPAD_NUM_SNS; i++)
+    {
+        sim_widget_config[CY_CAPSENSE_TOUCHPAD_WDGT_ID].ptrSnsContext[i].diff = scan_diffs[i];
+    }
+}
+
+/* The low power widget is not scanned in the frames, its status is cleared
+ * when processed; it is only refreshed by the Wake-On-Touch scans */
+cy_capsense_status_t Cy_CapSense_ProcessAllWidgets(cy_stc_capsense_context_t *context)
+{
+    (void)context;
+    sim_advance(sim_process_cycles);
+    process_touchpad_raw_counts();
+    process_touchpad_status();
+    cy_capsense_tuner.wdgtContext[CY_CAPSENSE_LOWPOWER0_WDGT_ID].status = 0u;
+    return CY_CAPSENSE_STATUS_SUCCESS;
+}
+
+cy_capsense_status_t Cy_CapSense_ProcessWidget(uint32_t widgetId, cy_stc_capsense_context_t *context)
+{
+    return Cy_CapSense_ProcessWidgetExt(widgetId, CY_CAPSENSE_PROCESS_ALL, context);
+}
+
+/* The status stage takes sim_process_status_cycles of sim_process_widget_cycles */
+cy_capsense_status_t Cy_CapSense_ProcessWidgetExt(uint32_t widgetId, uint32_t mode, cy_stc_capsense_context_t *context)
+{
+    (void)context;
+    if (0u != (mode & (uint32_t)~CY_CAPSENSE_PROCESS_STATUS))
+    {
+        sim_advance(sim_process_widget_cycles - sim_process_status_cycles);
+    }
+    if (0u != (mode & CY_CAPSENSE_PROCESS_STATUS))
+    {
+        sim_advance(sim_process_status_cycles);
+    }
+
+    if (CY_CAPSENSE_TOUCHPAD_WDGT_ID == widgetId)
+    {
+        if (0u != (mode & CY_CAPSENSE_PROCESS_DIFFCOUNTS))
+        {
+            process_touchpad_raw_counts();
+        }
+        if (0u != (mode & CY_CAPSENSE_PROCESS_STATUS))
+        {
+            process_touchpad_status();
+        }
+    }
+    else if (0u != (mode & CY_CAPSENSE_PROCESS_STATUS))
+    {
+        cy_capsense_tuner.wdgtContext[widgetId].status = 0u;
+    }
+    return CY_CAPSENSE_STATUS_SUCCESS;
+}
+
+uint32_t Cy_CapSense_DecodeWidgetGestures(uint32_t widgetId, const cy_stc_capsense_context_t *context)
+{
+    (void)widgetId;
+    (void)context;
+    sim_advance(sim_gesture_cycles);
+    return (NULL != sim_gesture_source) ? sim_gesture_source(now) : 0u;
+}
+
+uint32_t Cy_CapSense_IsAnyWidgetActive(const cy_stc_capsense_context_t *context)
+{
+    uint32_t i;
+    uint32_t active = 0u;
+
+    for (i = 0u; i < CY_CAPSENSE_TOTAL_WIDGET_COUNT; i++)
+    {
+        active |= context->ptrWdConfig[i].ptrWdContext->status & 1u;
+    }
+    return active;
+}
+
+/* A Wake-On-Touch ended by a touch leaves the low power widget active */
+uint32_t Cy_CapSense_IsAnyLpWidgetActive(const cy_stc_capsense_context_t *context)
+{
+    (void)context;
+    cy_capsense_tuner.wdgtContext[CY_CAPSENSE_LOWPOWER0_WDGT_ID].status = (uint8_t)wot_touched;
+    return wot_touched;
+}
+
+uint32_t Cy_CapSense_IsWidgetActive(uint32_t widgetId, const cy_stc_capsense_context_t *context)
+{
+    return context->ptrWdConfig[widgetId].ptrWdContext->status & 1u;
+}
+
+cy_stc_capsense_touch_t *Cy_CapSense_GetTouchInfo(uint32_t widgetId, const cy_stc_capsense_context_t *context)
+{
+    return &context->ptrWdConfig[widgetId].ptrWdContext->wdTouch;
+}
+
+/* Follows the command handling of the middleware: the receive callback is
+ * called before every command check, the command is cleared once handled,
+ * and the function loops while the Tuner suspends the scanning */
+uint32_t Cy_CapSense_RunTuner(cy_stc_capsense_context_t *context)
+{
+    cy_stc_capsense_common_context_t *ptrCommon = context->ptrCommonContext;
+    cy_capsense_tuner_receive_callback_t receiveCallback;
+    uint8_t *commandPacket;
+    uint8_t *tunerPacket;
+    uint32_t handled;
+    uint32_t loops = 0u;
+    uint32_t interruptStatus;
+
+    sim_advance(sim_tuner_cycles);
+
+    do
+    {
+        receiveCallback = context->ptrInternalContext->ptrTunerReceiveCallback;
+        if (NULL != receiveCallback)
+        {
+            commandPacket = NULL;
+            tunerPacket = NULL;
+            receiveCallback(&commandPacket, &tunerPacket, context);
+        }
+
+        handled = 1u;
+        switch (ptrCommon->tunerCmd)
+        {
+            case CY_CAPSENSE_TU_CMD_SUSPEND_E:
+                ptrCommon->tunerSt = CY_CAPSENSE_TU_FSM_SUSPENDED;
+                break;
+
+            case CY_CAPSENSE_TU_CMD_RESUME_E:
+            case CY_CAPSENSE_TU_CMD_PING_E:
+                ptrCommon->tunerSt = CY_CAPSENSE_TU_FSM_RUNNING;
+                break;
+
+            case CY_CAPSENSE_TU_CMD_RUN_SNAPSHOT_E:
+                ptrCommon->tunerSt = CY_CAPSENSE_TU_FSM_ONE_SCAN;
+                break;
+
+            default:
+                handled = 0u;
+                break;
+        }
+
+        if (0u != handled)
+        {
+            interruptStatus = Cy_SysLib_EnterCriticalSection();
+            ptrCommon->tunerCmd = CY_CAPSENSE_TU_CMD_NONE_E;
+            Cy_SysLib_ExitCriticalSection(interruptStatus);
+        }
+
+        if (NULL != sim_tuner_loop_hook)
+        {
+            sim_tuner_loop_hook();
+        }
+
+        if (++loops > SIM_TUNER_LOOP_LIMIT)
+        {
+            fprintf(stderr, "sim: Cy_CapSense_RunTuner() never resumed\n");
+            sim_failures++;
+            ptrCommon->tunerSt = CY_CAPSENSE_TU_FSM_RUNNING;
+        }
+    } while (CY_CAPSENSE_TU_FSM_SUSPENDED == ptrCommon->tunerSt);
+
+    ptrCommon->tunerCnt++;
+    return 0u;
+}
+
+void Cy_CapSense_IncrementGestureTimestamp(cy_stc_capsense_context_t *context)
+{
+    context->ptrCommonContext->timestamp += context->ptrCommonContext->timestampInterval;
+}
+
+/*******************************************************************************
+* Test reporting
+*******************************************************************************/
+void sim_assert_failed(const char *file, int line)
+{
+    fprintf(stderr, "%s:%d: CY_ASSERT failed\n", file, line);
+    sim_failures++;
+}
+
+void sim_check(int cond, const char *text, const char *file, int line)
+{
+    if (!cond)
+    {
+        fprintf(stderr, "%s:%d: check failed: %s\n", file, line, text);
+        sim_failures++;
+    }
+}
+
+int sim_report(const char *name)
+{
+    printf("%s: %s\n", name, (0u == sim_failures) ? "PASS" : "FAIL");
+    return (0u == sim_failures) ? 0 : 1;
+}
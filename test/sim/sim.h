@@ -0,0 +1,190 @@
+/******************************************************************************
+* File Name: sim.h
+*
+* Description: Host model of the PSoC 4000T peripherals used by main.c, for
+* the host tests and benchmarks. Time is virtual and counted in CPU cycles.
+* The firmware code itself runs in zero virtual time; the time is advanced by
+* the modeled middleware and driver calls, by the interrupt service routines
+* and by the CPU low power modes, which run until the next scheduled event.
+* An interrupt taken during a modeled call delays its end by the interrupt
+* execution time.
+*
+*******************************************************************************/
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include "cy_pdl.h"
+#include "cybsp.h"
+#include "cycfg_capsense.h"
+
+#define SIM_CYCLES_PER_US               (CY_CAPSENSE_CPU_CLK / 1000000u)
+#define SIM_US(us)                      ((uint64_t)(us) * SIM_CYCLES_PER_US)
+
+/* Number of ILO cycles per second, the clock of the MSCLP wake-up timer */
+#define SIM_ILO_FREQ                    (40000u)
+
+/*******************************************************************************
+* Virtual time and events
+*******************************************************************************/
+typedef void (*sim_event_fn)(void *arg);
+
+/* Resets the model, must be called before running the firmware code */
+void sim_reset(void);
+
+/* Current virtual time in CPU cycles */
+uint64_t sim_now(void);
+
+/* Schedules fn(arg) at the given virtual time, run from sim_advance() */
+void sim_schedule(uint64_t time, sim_event_fn fn, void *arg);
+
+/* Runs the CPU for the given cycles plus the time of the interrupts due meanwhile, delivering them and the events */
+void sim_advance(uint64_t cycles);
+
+/* Called by every CPU low power mode entry before the time is advanced; a test
+ * can stop the firmware main loop from it with longjmp */
+extern void (*sim_sleep_hook)(void);
+
+/* Called by every Cy_SysLib_EnterCriticalSection() before the interrupts are masked */
+extern void (*sim_critical_section_hook)(void);
+
+/* Runs the firmware entry point until the CPU enters a low power mode at or
+ * after the given virtual time, then returns with the interrupts enabled */
+void sim_run(int (*entry)(void), uint64_t until);
+
+/* Statistics of the CPU low power modes */
+typedef struct
+{
+    uint32_t sleepCount;
+    uint32_t deepSleepCount;
+    uint64_t sleepCycles;
+    uint64_t deepSleepCycles;
+} sim_power_stats_t;
+
+extern sim_power_stats_t sim_power_stats;
+
+/*******************************************************************************
+* Interrupts
+*******************************************************************************/
+/* Sets the interrupt pending and runs its handler if not masked */
+void sim_raise_irq(IRQn_Type irq);
+
+/* Virtual cycles consumed by each interrupt entry and exit */
+extern uint32_t sim_isr_overhead_cycles;
+
+/*******************************************************************************
+* EZI2C host side
+*******************************************************************************/
+#define SIM_EZI2C_BUFFER1               (1u)
+#define SIM_EZI2C_BUFFER2               (2u)
+
+/* Starts a transaction to the given buffer at the given sub-address; the slave
+ * is busy until sim_ezi2c_stop(). Each call runs the EZI2C interrupt */
+void sim_ezi2c_start(uint32_t buffer, uint32_t write, uint32_t offset);
+void sim_ezi2c_write(const void *data, uint32_t size);
+void sim_ezi2c_read(void *data, uint32_t size);
+void sim_ezi2c_stop(void);
+
+/* Complete transactions */
+void sim_host_write(uint32_t buffer, uint32_t offset, const void *data, uint32_t size);
+void sim_host_read(uint32_t buffer, uint32_t offset, void *data, uint32_t size);
+
+/* Buffers exposed by the firmware */
+uint8_t *sim_ezi2c_buffer(uint32_t buffer);
+uint32_t sim_ezi2c_buffer_size(uint32_t buffer);
+
+/* Virtual cycles consumed by the EZI2C driver per interrupt */
+extern uint32_t sim_ezi2c_isr_cycles;
+
+/*******************************************************************************
+* LED PWMs
+*******************************************************************************/
+#define SIM_PWM_COUNT                   (4u)
+
+/* Compare values of the PWM counters, indexed by the counter number */
+extern uint32_t sim_pwm_compare[SIM_PWM_COUNT];
+
+/*******************************************************************************
+* ILO and watchdog timer
+*******************************************************************************/
+/* Actual ILO frequency, the nominal one is SIM_ILO_FREQ */
+extern uint32_t sim_ilo_freq;
+
+/* Nonzero while the WDT is enabled */
+uint32_t sim_wdt_is_enabled(void);
+
+/*******************************************************************************
+* CAPSENSE
+*******************************************************************************/
+/* Wake-On-Touch scan interval and timeout, as set in the CAPSENSE Configurator */
+#define SIM_WOT_SCAN_INTERVAL_US        (62500u)
+#define SIM_WOT_TIMEOUT_SCANS           (160u)
+
+/* Touchpad scan time of a frame */
+#define SIM_SCAN_TIME_US                (923u)
+
+typedef struct
+{
+    uint16_t x;
+    uint16_t y;
+    uint16_t z;
+} sim_touch_t;
+
+/* Touches on the touchpad at the given virtual time, returns their count (up to
+ * CY_CAPSENSE_TOUCHPAD_NUM_TOUCHES). No touch if not set */
+extern uint32_t (*sim_touch_source)(uint64_t time, sim_touch_t *touches);
+
+/* Difference counts of the touchpad nodes at the given virtual time, indexed by
+ * column * CY_CAPSENSE_TOUCHPAD_NUM_ROWS + row. When set, the touch status and
+ * positions are computed from them by a generic CSX touchpad model driven by
+ * sim_widget_config; otherwise the touches of sim_touch_source are reported as
+ * they are. sim_touch_source still drives the Wake-On-Touch scans */
+extern void (*sim_touchpad_diff_source)(uint64_t time, uint16_t *diffs);
+
+/* Widget configuration, restored by sim_reset(). A test can change it to model another configuration */
+extern cy_stc_capsense_widget_config_t sim_widget_config[CY_CAPSENSE_TOTAL_WIDGET_COUNT];
+
+/* Gesture reported by Cy_CapSense_DecodeWidgetGestures() at the given virtual time. No gesture if not set */
+extern uint32_t (*sim_gesture_source)(uint64_t time);
+
+/* Virtual cycles consumed by the modeled middleware calls */
+extern uint32_t sim_process_cycles;         /* Cy_CapSense_ProcessAllWidgets() */
+extern uint32_t sim_process_widget_cycles;  /* Cy_CapSense_ProcessWidget() */
+extern uint32_t sim_process_status_cycles;  /* Its touch status stage, CY_CAPSENSE_PROCESS_STATUS */
+extern uint32_t sim_gesture_cycles;         /* Cy_CapSense_DecodeWidgetGestures() */
+extern uint32_t sim_tuner_cycles;           /* Cy_CapSense_RunTuner() */
+extern uint32_t sim_capsense_isr_cycles;    /* Cy_CapSense_InterruptHandler() */
+
+/* Frames scanned by Cy_CapSense_ScanAllSlots() and Wake-On-Touch scans started by Cy_CapSense_ScanAllLpSlots() */
+extern uint32_t sim_frame_count;
+extern uint32_t sim_wot_count;
+
+/* Virtual time of the last frame scan start and end, and of the last Wake-On-Touch start and end */
+extern uint64_t sim_scan_start_time;
+extern uint64_t sim_scan_end_time;
+extern uint64_t sim_wot_start_time;
+extern uint64_t sim_wot_end_time;
+
+/* Total virtual time of the Wake-On-Touch scans, from the start to the end */
+extern uint64_t sim_wot_cycles;
+
+/* Called in every iteration of the Cy_CapSense_RunTuner() command loop, after
+ * the command is handled, so a test can act as the host while the Tuner
+ * suspends the scanning */
+extern void (*sim_tuner_loop_hook)(void);
+
+/* Iterations of the Cy_CapSense_RunTuner() suspend loop before it is reported as a deadlock */
+#define SIM_TUNER_LOOP_LIMIT            (10000u)
+
+/*******************************************************************************
+* Test reporting
+*******************************************************************************/
+extern uint32_t sim_failures;
+
+#define SIM_CHECK(cond)                 sim_check((cond), #cond, __FILE__, __LINE__)
+void sim_check(int cond, const char *text, const char *file, int line);
+
+/* Prints the summary and returns the process exit code */
+int sim_report(const char *name);
+
+#endif /* SIM_H */
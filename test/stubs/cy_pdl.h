@@ -0,0 +1,183 @@
+/******************************************************************************
+* File Name: cy_pdl.h
+*
+* Description: Host build stand-in for the PSoC 4 Peripheral Driver Library.
+* Declares only the types and functions used by main.c; they are implemented
+* by the device model in sim/sim.c.
+*
+*******************************************************************************/
+#ifndef CY_PDL_H
+#define CY_PDL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef uint32_t cy_rslt_t;
+#define CY_RSLT_SUCCESS                     (0u)
+
+void sim_assert_failed(const char *file, int line);
+#define CY_ASSERT(x)                        do { if (!(x)) { sim_assert_failed(__FILE__, __LINE__); } } while (0)
+
+#define CY_MIN(a, b)                        (((a) < (b)) ? (a) : (b))
+#define CY_MAX(a, b)                        (((a) > (b)) ? (a) : (b))
+
+/* Interrupts */
+typedef int IRQn_Type;
+typedef void (*cy_israddress)(void);
+
+typedef struct
+{
+    IRQn_Type intrSrc;
+    uint32_t intrPriority;
+} cy_stc_sysint_t;
+
+int Cy_SysInt_Init(const cy_stc_sysint_t *config, cy_israddress userIsr);
+void NVIC_EnableIRQ(IRQn_Type irq);
+void NVIC_DisableIRQ(IRQn_Type irq);
+void NVIC_ClearPendingIRQ(IRQn_Type irq);
+uint32_t NVIC_GetPendingIRQ(IRQn_Type irq);
+void __enable_irq(void);
+void __disable_irq(void);
+
+/* System library */
+uint32_t Cy_SysLib_EnterCriticalSection(void);
+void Cy_SysLib_ExitCriticalSection(uint32_t savedIntrStatus);
+void Cy_SysLib_Delay(uint32_t milliseconds);
+
+/* System power management */
+typedef enum
+{
+    CY_SYSPM_SUCCESS,
+    CY_SYSPM_FAIL
+} cy_en_syspm_status_t;
+
+typedef enum
+{
+    CY_SYSPM_CHECK_READY        = 0x01u,
+    CY_SYSPM_CHECK_FAIL         = 0x02u,
+    CY_SYSPM_BEFORE_TRANSITION  = 0x04u,
+    CY_SYSPM_AFTER_TRANSITION   = 0x08u
+} cy_en_syspm_callback_mode_t;
+
+typedef enum
+{
+    CY_SYSPM_SLEEP,
+    CY_SYSPM_DEEPSLEEP
+} cy_en_syspm_callback_type_t;
+
+#define CY_SYSPM_SKIP_CHECK_READY           (0x01u)
+#define CY_SYSPM_SKIP_CHECK_FAIL            (0x02u)
+#define CY_SYSPM_SKIP_BEFORE_TRANSITION     (0x04u)
+#define CY_SYSPM_SKIP_AFTER_TRANSITION      (0x08u)
+
+typedef struct
+{
+    void *base;
+    void *context;
+} cy_stc_syspm_callback_params_t;
+
+typedef cy_en_syspm_status_t (*Cy_SysPmCallback)(cy_stc_syspm_callback_params_t *callbackParams,
+                                                 cy_en_syspm_callback_mode_t mode);
+
+typedef struct cy_stc_syspm_callback
+{
+    Cy_SysPmCallback callback;
+    cy_en_syspm_callback_type_t type;
+    uint32_t skipMode;
+    cy_stc_syspm_callback_params_t *callbackParams;
+    struct cy_stc_syspm_callback *prevItm;
+    struct cy_stc_syspm_callback *nextItm;
+    uint8_t order;
+} cy_stc_syspm_callback_t;
+
+bool Cy_SysPm_RegisterCallback(cy_stc_syspm_callback_t *handler);
+bool Cy_SysPm_UnregisterCallback(cy_stc_syspm_callback_t const *handler);
+cy_en_syspm_status_t Cy_SysPm_CpuEnterSleep(void);
+cy_en_syspm_status_t Cy_SysPm_CpuEnterDeepSleep(void);
+
+/* Serial communication block, EZI2C slave */
+typedef struct
+{
+    uint32_t reserved;
+} CySCB_Type;
+
+extern CySCB_Type sim_scb1;
+#define SCB1                                (&sim_scb1)
+
+typedef struct
+{
+    uint32_t baseAddr1;     /* Sub-address of the last transaction on the primary slave address */
+    uint8_t *curBuf;        /* Position in the buffer of the current or last transaction */
+    uint8_t *buf1;          /* Buffer of the primary slave address */
+} cy_stc_scb_ezi2c_context_t;
+
+typedef struct
+{
+    uint32_t reserved;
+} cy_stc_scb_ezi2c_config_t;
+
+typedef enum
+{
+    CY_SCB_EZI2C_SUCCESS
+} cy_en_scb_ezi2c_status_t;
+
+#define CY_SCB_EZI2C_STATUS_READ1           (0x01u)
+#define CY_SCB_EZI2C_STATUS_WRITE1          (0x02u)
+#define CY_SCB_EZI2C_STATUS_READ2           (0x04u)
+#define CY_SCB_EZI2C_STATUS_WRITE2          (0x08u)
+#define CY_SCB_EZI2C_STATUS_BUSY            (0x10u)
+#define CY_SCB_EZI2C_STATUS_ERR             (0x20u)
+
+cy_en_scb_ezi2c_status_t Cy_SCB_EZI2C_Init(CySCB_Type *base, cy_stc_scb_ezi2c_config_t const *config,
+                                           cy_stc_scb_ezi2c_context_t *context);
+void Cy_SCB_EZI2C_Enable(CySCB_Type *base);
+void Cy_SCB_EZI2C_SetBuffer1(CySCB_Type const *base, uint8_t *buffer, uint32_t size, uint32_t rwBoundary,
+                             cy_stc_scb_ezi2c_context_t *context);
+void Cy_SCB_EZI2C_SetBuffer2(CySCB_Type const *base, uint8_t *buffer, uint32_t size, uint32_t rwBoundary,
+                             cy_stc_scb_ezi2c_context_t *context);
+uint32_t Cy_SCB_EZI2C_GetActivity(CySCB_Type const *base, cy_stc_scb_ezi2c_context_t *context);
+void Cy_SCB_EZI2C_Interrupt(CySCB_Type *base, cy_stc_scb_ezi2c_context_t *context);
+cy_en_syspm_status_t Cy_SCB_EZI2C_DeepSleepCallback(cy_stc_syspm_callback_params_t *callbackParams,
+                                                    cy_en_syspm_callback_mode_t mode);
+
+/* Watchdog timer, a 16-bit counter clocked by the ILO */
+#define srss_interrupt_wdt_IRQn             (6)
+
+void Cy_WDT_Enable(void);
+void Cy_WDT_Disable(void);
+void Cy_WDT_SetMatch(uint32_t match);
+uint32_t Cy_WDT_GetMatch(void);
+uint32_t Cy_WDT_GetCount(void);
+void Cy_WDT_ClearInterrupt(void);
+void Cy_WDT_MaskInterrupt(void);
+void Cy_WDT_UnmaskInterrupt(void);
+
+/* SysTick */
+#define CY_SYSTICK_CLOCK_SOURCE_CLK_CPU     (4u)
+
+typedef void (*Cy_SysTick_Callback)(void);
+
+void Cy_SysTick_Init(uint32_t clockSource, uint32_t interval);
+void Cy_SysTick_SetCallback(uint32_t number, Cy_SysTick_Callback function);
+void Cy_SysTick_Clear(void);
+uint32_t Cy_SysTick_GetValue(void);
+
+/* Timer, counter, PWM */
+typedef struct
+{
+    uint32_t reserved;
+} TCPWM_Type;
+
+typedef struct
+{
+    uint32_t period0;
+} cy_stc_tcpwm_pwm_config_t;
+
+uint32_t Cy_TCPWM_PWM_Init(TCPWM_Type *base, uint32_t cntNum, cy_stc_tcpwm_pwm_config_t const *config);
+void Cy_TCPWM_Enable_Multiple(TCPWM_Type *base, uint32_t counters);
+void Cy_TCPWM_TriggerReloadOrIndex(TCPWM_Type *base, uint32_t counters);
+void Cy_TCPWM_PWM_SetCompare0(TCPWM_Type *base, uint32_t cntNum, uint32_t compare0);
+uint32_t Cy_TCPWM_PWM_GetCompare0(TCPWM_Type const *base, uint32_t cntNum);
+
+#endif /* CY_PDL_H */
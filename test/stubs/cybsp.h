@@ -0,0 +1,41 @@
+/******************************************************************************
+* File Name: cybsp.h
+*
+* Description: Host build stand-in for the board support package of the
+* CY8CPROTO-040T-MS kit. Declares the resources used by main.c.
+*
+*******************************************************************************/
+#ifndef CYBSP_H
+#define CYBSP_H
+
+#include "cy_pdl.h"
+
+cy_rslt_t cybsp_init(void);
+
+/* EZI2C slave */
+extern CySCB_Type *CYBSP_EZI2C_HW;
+extern const cy_stc_scb_ezi2c_config_t CYBSP_EZI2C_config;
+#define CYBSP_EZI2C_IRQ                     (10)
+
+/* LED PWMs */
+#define SIM_LED_PWM_COUNT                   (4u)
+
+extern TCPWM_Type *CYBSP_PWM_0_HW;
+extern TCPWM_Type *CYBSP_PWM_1_HW;
+extern TCPWM_Type *CYBSP_PWM_2_HW;
+extern TCPWM_Type *CYBSP_PWM_3_HW;
+extern const cy_stc_tcpwm_pwm_config_t CYBSP_PWM_0_config;
+extern const cy_stc_tcpwm_pwm_config_t CYBSP_PWM_1_config;
+extern const cy_stc_tcpwm_pwm_config_t CYBSP_PWM_2_config;
+extern const cy_stc_tcpwm_pwm_config_t CYBSP_PWM_3_config;
+
+#define CYBSP_PWM_0_NUM                     (0u)
+#define CYBSP_PWM_1_NUM                     (1u)
+#define CYBSP_PWM_2_NUM                     (2u)
+#define CYBSP_PWM_3_NUM                     (3u)
+#define CYBSP_PWM_0_MASK                    (1u << CYBSP_PWM_0_NUM)
+#define CYBSP_PWM_1_MASK                    (1u << CYBSP_PWM_1_NUM)
+#define CYBSP_PWM_2_MASK                    (1u << CYBSP_PWM_2_NUM)
+#define CYBSP_PWM_3_MASK                    (1u << CYBSP_PWM_3_NUM)
+
+#endif /* CYBSP_H */
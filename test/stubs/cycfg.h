@@ -0,0 +1,12 @@
+/******************************************************************************
+* File Name: cycfg.h
+*
+* Description: Host build stand-in for the generated device configuration.
+*
+*******************************************************************************/
+#ifndef CYCFG_H
+#define CYCFG_H
+
+#include "cy_pdl.h"
+
+#endif /* CYCFG_H */
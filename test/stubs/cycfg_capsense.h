@@ -0,0 +1,211 @@
+/******************************************************************************
+* File Name: cycfg_capsense.h
+*
+* Description: Host build stand-in for the generated CAPSENSE configuration
+* and the CAPSENSE middleware API. The configuration matches
+* config/design.cycapsense: a 4 x 5 CSX touchpad and a CSD low power widget.
+* The middleware functions are implemented by the device model in sim/sim.c.
+*
+*******************************************************************************/
+#ifndef CYCFG_CAPSENSE_H
+#define CYCFG_CAPSENSE_H
+
+#include "cy_pdl.h"
+
+typedef uint32_t cy_capsense_status_t;
+#define CY_CAPSENSE_STATUS_SUCCESS                          (0u)
+
+#define CY_CAPSENSE_CPU_CLK                                 (24000000u)
+
+#ifndef CY_CAPSENSE_GESTURE_EN
+#define CY_CAPSENSE_GESTURE_EN                              (1u)
+#endif
+
+/* Widgets */
+#define CY_CAPSENSE_TOUCHPAD_WDGT_ID                        (0u)
+#define CY_CAPSENSE_LOWPOWER0_WDGT_ID                       (1u)
+#define CY_CAPSENSE_TOTAL_WIDGET_COUNT                      (2u)
+
+#define CY_CAPSENSE_TOUCHPAD_NUM_COLS                       (4u)
+#define CY_CAPSENSE_TOUCHPAD_NUM_ROWS                       (5u)
+#define CY_CAPSENSE_TOUCHPAD_SNS0_ID                        (0u)
+#define CY_CAPSENSE_TOUCHPAD_NUM_SNS                        (CY_CAPSENSE_TOUCHPAD_NUM_COLS * CY_CAPSENSE_TOUCHPAD_NUM_ROWS)
+#define CY_CAPSENSE_TOUCHPAD_MAX_POSITION                   (255u)
+#define CY_CAPSENSE_TOUCHPAD_FINGER_TH                      (680u)
+#define CY_CAPSENSE_TOUCHPAD_HYSTERESIS                     (50u)
+#define CY_CAPSENSE_TOUCHPAD_ON_DEBOUNCE                    (3u)
+#define CY_CAPSENSE_TOUCHPAD_NUM_TOUCHES                    (2u)
+#define CY_CAPSENSE_SENSOR_COUNT                            (CY_CAPSENSE_TOUCHPAD_NUM_SNS + 1u)
+
+/* Gestures */
+#define CY_CAPSENSE_GESTURE_ONE_FNGR_SINGLE_CLICK_MASK      (0x0001u)
+#define CY_CAPSENSE_GESTURE_ONE_FNGR_DOUBLE_CLICK_MASK      (0x0002u)
+#define CY_CAPSENSE_GESTURE_ONE_FNGR_CLICK_DRAG_MASK        (0x0004u)
+#define CY_CAPSENSE_GESTURE_TWO_FNGR_SINGLE_CLICK_MASK      (0x0008u)
+#define CY_CAPSENSE_GESTURE_ONE_FNGR_FLICK_MASK             (0x0020u)
+#define CY_CAPSENSE_GESTURE_TWO_FNGR_ZOOM_MASK              (0x0080u)
+#define CY_CAPSENSE_GESTURE_TOUCHDOWN_MASK                  (0x1000u)
+#define CY_CAPSENSE_GESTURE_LIFTOFF_MASK                    (0x2000u)
+
+#define CY_CAPSENSE_GESTURE_DIRECTION_OFFSET                (16u)
+#define CY_CAPSENSE_GESTURE_DIRECTION_OFFSET_ONE_FLICK      (4u)
+#define CY_CAPSENSE_GESTURE_DIRECTION_OFFSET_TWO_ZOOM       (8u)
+
+#define CY_CAPSENSE_GESTURE_DIRECTION_UP                    (0u)
+#define CY_CAPSENSE_GESTURE_DIRECTION_DOWN                  (1u)
+#define CY_CAPSENSE_GESTURE_DIRECTION_RIGHT                 (2u)
+#define CY_CAPSENSE_GESTURE_DIRECTION_LEFT                  (3u)
+#define CY_CAPSENSE_GESTURE_DIRECTION_UP_RIGHT              (4u)
+#define CY_CAPSENSE_GESTURE_DIRECTION_DOWN_LEFT             (5u)
+#define CY_CAPSENSE_GESTURE_DIRECTION_DOWN_RIGHT            (6u)
+#define CY_CAPSENSE_GESTURE_DIRECTION_UP_LEFT               (7u)
+#define CY_CAPSENSE_GESTURE_DIRECTION_IN                    (0u)
+#define CY_CAPSENSE_GESTURE_DIRECTION_OUT                   (1u)
+
+#define CY_CAPSENSE_TOUCHPAD_CLICK_TIMEOUT_MAX_VALUE        (200u)
+#define CY_CAPSENSE_TOUCHPAD_SECOND_CLICK_INTERVAL_MIN_VALUE (20u)
+
+/* Widget status and the processing stages of Cy_CapSense_ProcessWidgetExt() */
+#define CY_CAPSENSE_WD_ACTIVE_MASK                          (0x01u)
+
+#define CY_CAPSENSE_PROCESS_FILTER                          (0x01u)
+#define CY_CAPSENSE_PROCESS_BASELINE                        (0x02u)
+#define CY_CAPSENSE_PROCESS_DIFFCOUNTS                      (0x04u)
+#define CY_CAPSENSE_PROCESS_CALC_NOISE                      (0x08u)
+#define CY_CAPSENSE_PROCESS_THRESHOLDS                      (0x10u)
+#define CY_CAPSENSE_PROCESS_STATUS                          (0x20u)
+#define CY_CAPSENSE_PROCESS_ALL                             (0x3Fu)
+
+/* Centroid and position filter configuration of a widget */
+#define CY_CAPSENSE_CENTROID_5X5_MASK                       (0x0010u)
+#define CY_CAPSENSE_CENTROID_3X3_MASK                       (0x0020u)
+#define CY_CAPSENSE_EDGE_CORRECTION_MASK                    (0x0040u)
+#define CY_CAPSENSE_CENTROID_BALLISTIC_MASK                 (0x0080u)
+#define CY_CAPSENSE_POSITION_FILTERS_MASK                   (0x000000FFu)
+
+/* Tuner commands and states */
+#define CY_CAPSENSE_TU_CMD_NONE_E                           (0u)
+#define CY_CAPSENSE_TU_CMD_SUSPEND_E                        (1u)
+#define CY_CAPSENSE_TU_CMD_RESUME_E                         (2u)
+#define CY_CAPSENSE_TU_CMD_RESTART_E                        (3u)
+#define CY_CAPSENSE_TU_CMD_RUN_SNAPSHOT_E                   (4u)
+#define CY_CAPSENSE_TU_CMD_PING_E                           (5u)
+
+#define CY_CAPSENSE_TU_FSM_RUNNING                          (0x00u)
+#define CY_CAPSENSE_TU_FSM_SUSPENDED                        (0x01u)
+#define CY_CAPSENSE_TU_FSM_ONE_SCAN                         (0x03u)
+
+/* MSCLP */
+#define CY_MSCLP0_LP_IRQ                                    (3)
+#define CY_MSCLP0_HW                                        ((void *)0)
+
+typedef struct
+{
+    uint16_t x;
+    uint16_t y;
+    uint16_t z;
+    uint16_t id;
+} cy_stc_capsense_position_t;
+
+typedef struct
+{
+    cy_stc_capsense_position_t *ptrPosition;
+    uint8_t numPosition;
+} cy_stc_capsense_touch_t;
+
+typedef struct
+{
+    uint16_t configId;
+    uint16_t tunerCmd;
+    uint16_t scanCounter;
+    uint8_t tunerSt;
+    uint8_t initDone;
+    uint16_t tunerCnt;
+    uint16_t timestampInterval;
+    uint32_t timestamp;
+    uint32_t status;
+} cy_stc_capsense_common_context_t;
+
+typedef void (*cy_capsense_tuner_send_callback_t)(void *context);
+typedef void (*cy_capsense_tuner_receive_callback_t)(uint8_t **commandPacket, uint8_t **tunerPacket, void *context);
+
+typedef struct
+{
+    cy_capsense_tuner_send_callback_t ptrTunerSendCallback;
+    cy_capsense_tuner_receive_callback_t ptrTunerReceiveCallback;
+} cy_stc_capsense_internal_context_t;
+
+typedef struct
+{
+    uint16_t fingerTh;
+    uint16_t proxTh;
+    uint16_t noiseTh;
+    uint16_t nNoiseTh;
+    uint16_t hysteresis;
+    uint8_t onDebounce;
+    uint8_t lowBslnRst;
+    uint16_t maxRawCount;
+    uint8_t status;
+    cy_stc_capsense_touch_t wdTouch;
+} cy_stc_capsense_widget_context_t;
+
+typedef struct
+{
+    uint16_t raw;
+    uint16_t bsln;
+    uint16_t diff;
+    uint8_t status;
+    uint8_t negBslnRstCnt;
+} cy_stc_capsense_sensor_context_t;
+
+typedef struct
+{
+    cy_stc_capsense_widget_context_t *ptrWdContext;
+    cy_stc_capsense_sensor_context_t *ptrSnsContext;
+    uint16_t numSns;
+    uint8_t numCols;
+    uint8_t numRows;
+    uint16_t xResolution;
+    uint16_t yResolution;
+    uint16_t centroidConfig;
+    uint32_t posFilterConfig;
+} cy_stc_capsense_widget_config_t;
+
+typedef struct
+{
+    cy_stc_capsense_common_context_t *ptrCommonContext;
+    cy_stc_capsense_internal_context_t *ptrInternalContext;
+    const cy_stc_capsense_widget_config_t *ptrWdConfig;
+} cy_stc_capsense_context_t;
+
+typedef struct
+{
+    cy_stc_capsense_common_context_t commonContext;
+    cy_stc_capsense_widget_context_t wdgtContext[CY_CAPSENSE_TOTAL_WIDGET_COUNT];
+    cy_stc_capsense_sensor_context_t snsContext[CY_CAPSENSE_SENSOR_COUNT];
+    cy_stc_capsense_position_t position_Touchpad[CY_CAPSENSE_TOUCHPAD_NUM_TOUCHES];
+} cy_stc_capsense_tuner_t;
+
+extern cy_stc_capsense_tuner_t cy_capsense_tuner;
+extern cy_stc_capsense_context_t cy_capsense_context;
+
+cy_capsense_status_t Cy_CapSense_Init(cy_stc_capsense_context_t *context);
+cy_capsense_status_t Cy_CapSense_Enable(cy_stc_capsense_context_t *context);
+void Cy_CapSense_InterruptHandler(void *base, cy_stc_capsense_context_t *context);
+void Cy_CapSense_IloCompensate(cy_stc_capsense_context_t *context);
+cy_capsense_status_t Cy_CapSense_ConfigureMsclpTimer(uint32_t wakeupTimer, cy_stc_capsense_context_t *context);
+cy_capsense_status_t Cy_CapSense_ScanAllSlots(cy_stc_capsense_context_t *context);
+cy_capsense_status_t Cy_CapSense_ScanAllLpSlots(cy_stc_capsense_context_t *context);
+uint32_t Cy_CapSense_IsBusy(const cy_stc_capsense_context_t *context);
+cy_capsense_status_t Cy_CapSense_ProcessAllWidgets(cy_stc_capsense_context_t *context);
+cy_capsense_status_t Cy_CapSense_ProcessWidgetExt(uint32_t widgetId, uint32_t mode, cy_stc_capsense_context_t *context);
+cy_capsense_status_t Cy_CapSense_ProcessWidget(uint32_t widgetId, cy_stc_capsense_context_t *context);
+uint32_t Cy_CapSense_DecodeWidgetGestures(uint32_t widgetId, const cy_stc_capsense_context_t *context);
+uint32_t Cy_CapSense_IsAnyWidgetActive(const cy_stc_capsense_context_t *context);
+uint32_t Cy_CapSense_IsAnyLpWidgetActive(const cy_stc_capsense_context_t *context);
+uint32_t Cy_CapSense_IsWidgetActive(uint32_t widgetId, const cy_stc_capsense_context_t *context);
+cy_stc_capsense_touch_t *Cy_CapSense_GetTouchInfo(uint32_t widgetId, const cy_stc_capsense_context_t *context);
+uint32_t Cy_CapSense_RunTuner(cy_stc_capsense_context_t *context);
+void Cy_CapSense_IncrementGestureTimestamp(cy_stc_capsense_context_t *context);
+
+#endif /* CYCFG_CAPSENSE_H */
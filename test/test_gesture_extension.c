@@ -0,0 +1,96 @@
+/******************************************************************************
+* File Name: test_gesture_extension.c
+*
+* Description: Tests of the gesture extension (ENABLE_GESTURE_EXTENSION) with
+* the firmware main loop: the dial rotation reported for turns at different
+* speeds, including turns slow enough to move less than 0.1 degree in some
+* frames, matches the angle swept by the scanned positions.
+*
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "sim.h"
+
+#define main firmware_main
+#include "main.c"
+#undef main
+#include "firmware_reset.h"
+
+#define DIAL_START_US           (500000u)
+#define DIAL_RADIUS             (100.0)
+
+static uint64_t turn_time;
+static double turns;
+
+/* Angle swept by the scanned positions in 0.1 degrees, the reference of the rotation */
+static double swept;
+static double last_angle;
+static uint32_t touching;
+
+/* One finger moving on a circle around the touchpad center from DIAL_START_US for turn_time */
+static uint32_t dial_source(uint64_t time, sim_touch_t *touches)
+{
+    double angle;
+    double delta;
+
+    if ((time < SIM_US(DIAL_START_US)) || (time >= (SIM_US(DIAL_START_US) + turn_time)))
+    {
+        touching = 0u;
+        return 0u;
+    }
+    angle = 2.0 * M_PI * turns * (double)(time - SIM_US(DIAL_START_US)) / (double)turn_time;
+    touches[0].x = (uint16_t)lround(TOUCHPAD_CENTER + DIAL_RADIUS * cos(angle));
+    touches[0].y = (uint16_t)lround(TOUCHPAD_CENTER + DIAL_RADIUS * sin(angle));
+    touches[0].z = 100u;
+
+    angle = atan2((double)touches[0].y - TOUCHPAD_CENTER, (double)touches[0].x - TOUCHPAD_CENTER);
+    if (0u != touching)
+    {
+        delta = remainder(angle - last_angle, 2.0 * M_PI);
+        swept += delta * 1800.0 / M_PI;
+    }
+    last_angle = angle;
+    touching = 1u;
+    return 1u;
+}
+
+/* Returns the reported rotation in 0.1 degrees after the given turns in the given time */
+static int32_t run_dial(double dial_turns, uint32_t time_ms)
+{
+    firmware_reset();
+
+    turns = dial_turns;
+    swept = 0.0;
+    touching = 0u;
+    turn_time = SIM_US((uint64_t)time_ms * 1000u);
+    sim_touch_source = dial_source;
+
+    sim_run(firmware_main, SIM_US(DIAL_START_US) + turn_time + SIM_US(100000u));
+
+    return host_interface.gestureReport.rotation;
+}
+
+static void check_dial(double dial_turns, uint32_t time_ms)
+{
+    int32_t rotation = run_dial(dial_turns, time_ms);
+    int32_t expected = (int32_t)lround(swept);
+
+    printf("  %5.2f turns in %5u ms: rotation %6d, expected %6d\n", dial_turns, (unsigned)time_ms,
+           (int)rotation, (int)expected);
+
+    /* Within 0.3 %, the error of the small angle approximation */
+    SIM_CHECK(abs(rotation - expected) <= ((abs(expected) * 3) / 1000 + 1));
+}
+
+int main(void)
+{
+    check_dial(1.0, 1000u);
+    check_dial(2.0, 3000u);
+    check_dial(1.0, 4000u);
+    check_dial(-1.0, 4000u);
+    check_dial(0.5, 8000u);
+    check_dial(-0.25, 6000u);
+
+    return sim_report("test_gesture_extension");
+}
@@ -0,0 +1,586 @@
+/******************************************************************************
+* File Name: test_gesture_timing.c
+*
+* Description: Regression tests and latency benchmark of the gesture timing:
+* the double click detection in double_click_timeout(), the LED on time and
+* double click timers advanced by advance_gesture_timers(), and the gesture to
+* LED mapping in led_control().
+*
+* Scripted gesture sequences with exact timestamps are replayed in two ways:
+*  - directly through double_click_timeout(), advance_gesture_timers() and
+*    led_control() on a virtual millisecond clock, with the timers advanced at
+*    1 ms, 10 ms and the TIMESTAMP_INTERVAL_IN_MILSEC granularity
+*  - through the firmware main loop, with the gestures reported by the
+*    modeled Cy_CapSense_DecodeWidgetGestures() and the timers advanced by the
+*    SysTick and the Deep Sleep catch-up of the sleep manager
+* Every sequence is replayed at a range of phases against the frames and the
+* timer ticks. The sequence of gestures held for the LEDs and the LED outputs
+* are checked, and the worst case confirmation latency of each gesture type,
+* from the scripted time of the gesture to the end of the frame confirming it,
+* is printed and checked against the bounds derived from the timeouts, the
+* granularity and the frame period. The main loop replay charges modeled
+* execution times of the middleware and the Tuner to the virtual clock, so its
+* latencies include the scan and the processing of the frame.
+*
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include "sim.h"
+
+#define main firmware_main
+#include "main.c"
+#undef main
+#include "firmware_reset.h"
+
+#define MS(ms)                      SIM_US((uint64_t)(ms) * 1000u)
+
+/* Frame period of the ACTIVE mode in us, 1/128 s */
+#define FRAME_US                    (1000000.0 / ACTIVE_MODE_REFRESH_RATE)
+
+/* Modeled execution times of the middleware and the Tuner in the main loop replay, within
+ * ACTIVE_MODE_PROCESS_TIME */
+#define PROCESS_US                  (120u)
+#define GESTURE_US                  (30u)
+#define TUNER_US                    (15u)
+#define CAPSENSE_ISR_US             (8u)
+
+/* Start of the scripted sequences in the firmware main loop, after the initialization */
+#define SCRIPT_START_MS             (200u)
+
+/* Length of a replay, long enough for the LED timeout after the last gesture */
+#define SCRIPT_LENGTH_MS            (2000u)
+
+/* Phases of the sequences against the frames and the timer ticks */
+#define PHASE_STEP_US               (250u)
+#define PHASE_RANGE_US              (2u * TIMESTAMP_INTERVAL_IN_MILSEC * 1000u)
+
+#define MAX_EVENTS                  (8u)
+#define MAX_HELD                    (8u)
+#define MAX_CONTACTS                (3u)
+
+#define LED_BLUE                    (0x1u)      /* CYBSP_PWM_2 */
+#define LED_AMBER                   (0x2u)      /* CYBSP_PWM_3 */
+
+typedef enum
+{
+    TYPE_SINGLE_CLICK,
+    TYPE_DOUBLE_CLICK,
+    TYPE_TWO_FINGER_CLICK,
+    TYPE_CLICK_DRAG,
+    TYPE_FLICK,
+    TYPE_ZOOM,
+    TYPE_NONE,
+    TYPE_COUNT = TYPE_NONE
+} gesture_type_t;
+
+static const char *const type_names[TYPE_COUNT] =
+{
+    "click", "double", "2 finger", "drag", "flick", "zoom"
+};
+
+typedef struct
+{
+    uint32_t time_ms;
+    uint32_t gesture;
+} script_event_t;
+
+typedef struct
+{
+    uint32_t start_ms;
+    uint32_t end_ms;
+} script_contact_t;
+
+typedef struct
+{
+    const char *name;
+    script_event_t events[MAX_EVENTS];
+    script_contact_t contacts[MAX_CONTACTS];
+
+    /* Expected values of gestureHeldForLed, in the order they are taken */
+    uint32_t held[MAX_HELD];
+    uint32_t heldCount;
+
+    /* Event whose confirmation latency is measured and its gesture type */
+    uint32_t trigger;
+    gesture_type_t type;
+
+    /* LEDs lit by the gesture, and whether they blink */
+    uint32_t leds;
+    uint32_t blink;
+} script_t;
+
+static const script_t scripts[] =
+{
+    {
+        "single click",
+        { { 0u, TOUCHDOWN_GESTURE }, { 80u, ONE_FNGR_SINGLE_CLICK_GESTURE } },
+        { { 0u, 80u } },
+        { ONE_FNGR_SINGLE_CLICK_GESTURE, 0u }, 2u, 1u, TYPE_SINGLE_CLICK, LED_BLUE, 0u
+    },
+    {
+        "double click",
+        { { 0u, TOUCHDOWN_GESTURE }, { 80u, ONE_FNGR_SINGLE_CLICK_GESTURE },
+          { 150u, TOUCHDOWN_GESTURE }, { 230u, ONE_FNGR_DOUBLE_CLICK_GESTURE } },
+        { { 0u, 80u }, { 150u, 230u } },
+        { ONE_FNGR_DOUBLE_CLICK_GESTURE, 0u }, 2u, 3u, TYPE_DOUBLE_CLICK, LED_AMBER, 0u
+    },
+    {
+        "two single clicks",
+        { { 0u, TOUCHDOWN_GESTURE }, { 80u, ONE_FNGR_SINGLE_CLICK_GESTURE },
+          { 1000u, TOUCHDOWN_GESTURE }, { 1080u, ONE_FNGR_SINGLE_CLICK_GESTURE } },
+        { { 0u, 80u }, { 1000u, 1080u } },
+        { ONE_FNGR_SINGLE_CLICK_GESTURE, 0u, ONE_FNGR_SINGLE_CLICK_GESTURE, 0u }, 4u, 3u, TYPE_SINGLE_CLICK,
+        LED_BLUE, 0u
+    },
+    {
+        "two finger click",
+        { { 0u, TOUCHDOWN_GESTURE }, { 80u, TWO_FNGR_SINGLE_CLICK_GESTURE } },
+        { { 0u, 80u } },
+        { TWO_FNGR_SINGLE_CLICK_GESTURE, 0u }, 2u, 1u, TYPE_TWO_FINGER_CLICK, LED_BLUE | LED_AMBER, 0u
+    },
+    {
+        "click and drag",
+        { { 0u, TOUCHDOWN_GESTURE }, { 80u, ONE_FNGR_SINGLE_CLICK_GESTURE },
+          { 150u, TOUCHDOWN_GESTURE }, { 250u, CY_CAPSENSE_GESTURE_ONE_FNGR_CLICK_DRAG_MASK },
+          { 400u, LIFTOFF_GESTURE } },
+        { { 0u, 80u }, { 150u, 400u } },
+        { CY_CAPSENSE_GESTURE_ONE_FNGR_CLICK_DRAG_MASK, 0u }, 2u, 3u, TYPE_CLICK_DRAG, LED_BLUE, 0u
+    },
+    {
+        "flick up",
+        { { 0u, TOUCHDOWN_GESTURE }, { 120u, FLICK_GESTURE_UP } },
+        { { 0u, 120u } },
+        { FLICK_GESTURE_UP, 0u }, 2u, 1u, TYPE_FLICK, LED_AMBER, 1u
+    },
+    {
+        "flick down",
+        { { 0u, TOUCHDOWN_GESTURE }, { 120u, FLICK_GESTURE_DOWN } },
+        { { 0u, 120u } },
+        { FLICK_GESTURE_DOWN, 0u }, 2u, 1u, TYPE_FLICK, LED_BLUE, 1u
+    },
+    {
+        /* The left and right flicks blink the position LEDs, which also show the touch */
+        "flick left",
+        { { 0u, TOUCHDOWN_GESTURE }, { 120u, FLICK_GESTURE_LEFT } },
+        { { 0u, 120u } },
+        { FLICK_GESTURE_LEFT, 0u }, 2u, 1u, TYPE_FLICK, 0u, 0u
+    },
+    {
+        "flick right",
+        { { 0u, TOUCHDOWN_GESTURE }, { 120u, FLICK_GESTURE_RIGHT } },
+        { { 0u, 120u } },
+        { FLICK_GESTURE_RIGHT, 0u }, 2u, 1u, TYPE_FLICK, 0u, 0u
+    },
+    {
+        "click then flick",
+        { { 0u, TOUCHDOWN_GESTURE }, { 80u, ONE_FNGR_SINGLE_CLICK_GESTURE },
+          { 150u, TOUCHDOWN_GESTURE }, { 250u, FLICK_GESTURE_UP } },
+        { { 0u, 80u }, { 150u, 250u } },
+        { FLICK_GESTURE_UP, 0u }, 2u, 3u, TYPE_FLICK, LED_AMBER, 1u
+    },
+    {
+        "zoom in",
+        { { 0u, TOUCHDOWN_GESTURE }, { 200u, Zoom_in } },
+        { { 0u, 200u } },
+        { Zoom_in, 0u }, 2u, 1u, TYPE_ZOOM, 0u, 0u
+    },
+    {
+        "touch only",
+        { { 0u, TOUCHDOWN_GESTURE }, { 300u, LIFTOFF_GESTURE } },
+        { { 0u, 300u } },
+        { 0u }, 0u, 0u, TYPE_NONE, 0u, 0u
+    },
+};
+
+#define SCRIPT_COUNT                (sizeof(scripts) / sizeof(scripts[0]))
+
+/* Observation of one replay */
+typedef struct
+{
+    uint32_t held[MAX_HELD];
+    uint64_t heldTime[MAX_HELD];
+    uint32_t heldCount;
+    uint64_t eventTime[MAX_EVENTS];    /* Scripted time of the gesture */
+    uint64_t reportTime[MAX_EVENTS];   /* Time the gesture is reported by the decoding */
+    uint32_t reported;
+    uint64_t ledOnTime;
+    uint32_t ledsSeen;
+    uint32_t blinkOffs;
+    uint32_t lastLeds;
+} observation_t;
+
+/* Worst and best case latencies in us of each gesture type, and of the release of the LEDs */
+typedef struct
+{
+    double confirmMax[TYPE_COUNT];      /* From the scripted gesture */
+    double confirmMin[TYPE_COUNT];
+    double heldMax[TYPE_COUNT];         /* From the report of the gesture */
+    double ledMax[TYPE_COUNT];          /* From the gesture held, sampled at the end of the frames */
+    double releaseMax;
+    double releaseMin;
+} latency_t;
+
+static const script_t *script;
+static uint64_t script_start;
+static observation_t obs;
+
+static uint32_t script_events(const script_t *s)
+{
+    uint32_t count = 0u;
+
+    while ((count < MAX_EVENTS) && (0u != s->events[count].gesture))
+    {
+        count++;
+    }
+    return count;
+}
+
+static void reset_latency(latency_t *lat)
+{
+    uint32_t i;
+
+    for (i = 0u; i < TYPE_COUNT; i++)
+    {
+        lat->confirmMax[i] = 0.0;
+        lat->confirmMin[i] = 1e12;
+        lat->heldMax[i] = 0.0;
+        lat->ledMax[i] = 0.0;
+    }
+    lat->releaseMax = 0.0;
+    lat->releaseMin = 1e12;
+}
+
+static uint32_t leds_on(void)
+{
+    return ((0u != sim_pwm_compare[CYBSP_PWM_2_NUM]) ? LED_BLUE : 0u) |
+           ((0u != sim_pwm_compare[CYBSP_PWM_3_NUM]) ? LED_AMBER : 0u);
+}
+
+/* Records a change of the held gesture and of the LEDs at the given time in cycles */
+static void observe(uint64_t time)
+{
+    uint32_t held = gestureHeldForLed;
+    uint32_t leds = leds_on();
+    uint32_t last = (0u != obs.heldCount) ? obs.held[obs.heldCount - 1u] : 0u;
+
+    if ((held != last) && (obs.heldCount < MAX_HELD))
+    {
+        obs.held[obs.heldCount] = held;
+        obs.heldTime[obs.heldCount] = time;
+        obs.heldCount++;
+    }
+
+    if ((0u != leds) && (0u == obs.ledsSeen))
+    {
+        obs.ledOnTime = time;
+    }
+    if ((0u != obs.lastLeds) && (leds != obs.lastLeds))
+    {
+        obs.blinkOffs += (0u != held) ? 1u : 0u;
+    }
+    obs.ledsSeen |= leds;
+    obs.lastLeds = leds;
+}
+
+/* Checks one replay against its script and accumulates the latencies in us */
+static uint32_t check_replay(const script_t *s, latency_t *lat, uint32_t count_leds, double led_bound_us)
+{
+    uint32_t failures = sim_failures;
+    uint32_t confirm;
+    double latency;
+    uint32_t i;
+
+    SIM_CHECK(obs.reported == script_events(s));
+    SIM_CHECK(obs.heldCount == s->heldCount);
+    for (i = 0u; (i < obs.heldCount) && (i < s->heldCount); i++)
+    {
+        SIM_CHECK(obs.held[i] == s->held[i]);
+    }
+
+    if (0u != count_leds)
+    {
+        SIM_CHECK(obs.ledsSeen == s->leds);
+        SIM_CHECK((0u != s->blink) == (0u != obs.blinkOffs));
+    }
+
+    if ((TYPE_NONE != s->type) && (obs.heldCount == s->heldCount) && (obs.reported == script_events(s)))
+    {
+        /* The held gesture taken after the trigger event */
+        confirm = obs.heldCount - 2u;
+        latency = (double)(obs.heldTime[confirm] - obs.eventTime[s->trigger]) / SIM_CYCLES_PER_US;
+        lat->confirmMax[s->type] = (latency > lat->confirmMax[s->type]) ? latency : lat->confirmMax[s->type];
+        lat->confirmMin[s->type] = (latency < lat->confirmMin[s->type]) ? latency : lat->confirmMin[s->type];
+
+        latency = (double)(obs.heldTime[confirm] - obs.reportTime[s->trigger]) / SIM_CYCLES_PER_US;
+        lat->heldMax[s->type] = (latency > lat->heldMax[s->type]) ? latency : lat->heldMax[s->type];
+
+        latency = (double)(obs.heldTime[confirm + 1u] - obs.heldTime[confirm]) / SIM_CYCLES_PER_US;
+        lat->releaseMax = (latency > lat->releaseMax) ? latency : lat->releaseMax;
+        lat->releaseMin = (latency < lat->releaseMin) ? latency : lat->releaseMin;
+
+        if ((0u != count_leds) && (0u != s->leds))
+        {
+            latency = (double)(obs.ledOnTime - obs.heldTime[0]) / SIM_CYCLES_PER_US;
+            lat->ledMax[s->type] = (latency > lat->ledMax[s->type]) ? latency : lat->ledMax[s->type];
+            SIM_CHECK(latency <= led_bound_us);
+        }
+    }
+
+    return (failures == sim_failures) ? 1u : 0u;
+}
+
+/*******************************************************************************
+* Direct replay on a virtual millisecond clock
+*******************************************************************************/
+
+/* Replays the script with the first event at phase_us, the timers advanced
+ * every granularity_ms and the frames every FRAME_US. Times are kept in us and
+ * reported in cycles for the observation */
+static void replay_direct(const script_t *s, uint32_t phase_us, uint32_t granularity_ms)
+{
+    uint32_t count = script_events(s);
+    uint32_t next = 0u;
+    uint32_t frame = 0u;
+    uint64_t tick_us = granularity_ms * 1000u;
+    uint64_t frame_us;
+
+    firmware_reset();
+    memset(&obs, 0, sizeof(obs));
+
+    for (frame = 0u; ; frame++)
+    {
+        frame_us = (uint64_t)((double)frame * FRAME_US);
+        if (frame_us > ((uint64_t)SCRIPT_LENGTH_MS * 1000u))
+        {
+            break;
+        }
+
+        /* The timer ticks due before this frame */
+        while (tick_us <= frame_us)
+        {
+            advance_gesture_timers(granularity_ms);
+            tick_us += granularity_ms * 1000u;
+        }
+
+        /* One gesture per frame, reported in the first frame at or after its time */
+        gesture = 0u;
+        if ((next < count) && (frame_us >= (phase_us + ((uint64_t)s->events[next].time_ms * 1000u))))
+        {
+            gesture = s->events[next].gesture;
+            obs.eventTime[next] = SIM_US(phase_us + ((uint64_t)s->events[next].time_ms * 1000u));
+            obs.reportTime[next] = SIM_US(frame_us);
+            obs.reported++;
+            next++;
+        }
+
+        double_click_timeout();
+        led_control();
+        observe(SIM_US(frame_us));
+    }
+}
+
+static void test_direct(uint32_t granularity_ms, const char *label)
+{
+    latency_t lat;
+    uint32_t i;
+    uint32_t phase;
+    uint32_t ticks;
+    double bound;
+    double low;
+    uint32_t failed = 0u;
+
+    reset_latency(&lat);
+
+    for (i = 0u; i < SCRIPT_COUNT; i++)
+    {
+        for (phase = 0u; phase < PHASE_RANGE_US; phase += PHASE_STEP_US)
+        {
+            replay_direct(&scripts[i], 1000u + phase, granularity_ms);
+            if ((0u == check_replay(&scripts[i], &lat, 1u, FRAME_US)) && (0u == failed))
+            {
+                printf("  %s: %s failed at phase %u us\n", label, scripts[i].name, (unsigned)phase);
+                failed = 1u;
+            }
+        }
+    }
+
+    printf("  %-18s", label);
+    for (i = 0u; i < TYPE_COUNT; i++)
+    {
+        printf(" %8.1f", lat.confirmMax[i] / 1000.0);
+    }
+    printf(" %8.1f\n", lat.releaseMax / 1000.0);
+
+    /* A gesture is reported in the first frame at or after it. The click is
+     * confirmed in the first frame after the timer ticks exceed
+     * DOUBLE_CLICK_TIMEOUT; the ticks run asynchronously to the frames */
+    ticks = (DOUBLE_CLICK_TIMEOUT / granularity_ms) + 1u;
+    low = (double)(ticks - 1u) * granularity_ms * 1000.0;
+    bound = ((double)ticks * granularity_ms * 1000.0) + (2.0 * FRAME_US);
+    SIM_CHECK(lat.confirmMin[TYPE_SINGLE_CLICK] > low);
+    SIM_CHECK(lat.confirmMax[TYPE_SINGLE_CLICK] <= bound);
+
+    /* The other gestures are held in the frame reporting them */
+    for (i = TYPE_DOUBLE_CLICK; i < TYPE_COUNT; i++)
+    {
+        SIM_CHECK(0.0 == lat.heldMax[i]);
+        SIM_CHECK(lat.confirmMax[i] < FRAME_US);
+    }
+
+    /* The LEDs are released in the first frame after the timer ticks reach LED_TIMEOUT_IN_MILSEC */
+    ticks = (LED_TIMEOUT_IN_MILSEC + granularity_ms - 1u) / granularity_ms;
+    low = (double)(ticks - 1u) * granularity_ms * 1000.0;
+    bound = ((double)ticks * granularity_ms * 1000.0) + FRAME_US;
+    SIM_CHECK(lat.releaseMin > low);
+    SIM_CHECK(lat.releaseMax <= bound);
+}
+
+/*******************************************************************************
+* Replay through the firmware main loop
+*******************************************************************************/
+static uint32_t next_event;
+
+static uint64_t event_time(uint32_t index)
+{
+    return script_start + MS(script->events[index].time_ms);
+}
+
+static uint32_t gesture_source(uint64_t time)
+{
+    uint32_t result = 0u;
+
+    if ((next_event < script_events(script)) && (time >= event_time(next_event)))
+    {
+        result = script->events[next_event].gesture;
+        obs.eventTime[next_event] = event_time(next_event);
+        obs.reportTime[next_event] = time;
+        obs.reported++;
+        next_event++;
+    }
+    return result;
+}
+
+static uint32_t touch_source(uint64_t time, sim_touch_t *touches)
+{
+    uint32_t i;
+
+    for (i = 0u; (i < MAX_CONTACTS) && (0u != script->contacts[i].end_ms); i++)
+    {
+        if ((time >= (script_start + MS(script->contacts[i].start_ms))) &&
+            (time < (script_start + MS(script->contacts[i].end_ms))))
+        {
+            touches[0].x = TOUCHPAD_MAX_POSITION / 2u;
+            touches[0].y = TOUCHPAD_MAX_POSITION / 2u;
+            touches[0].z = 100u;
+            return 1u;
+        }
+    }
+    return 0u;
+}
+
+/* The held gesture and the LEDs are observed at every low power mode entry, after the frame processing and the tasks */
+static void sleep_hook(void)
+{
+    observe(sim_now());
+}
+
+static void replay_loop(const script_t *s, uint32_t phase_us)
+{
+    firmware_reset();
+    memset(&obs, 0, sizeof(obs));
+
+    sim_process_cycles = SIM_US(PROCESS_US);
+    sim_gesture_cycles = SIM_US(GESTURE_US);
+    sim_tuner_cycles = SIM_US(TUNER_US);
+    sim_capsense_isr_cycles = SIM_US(CAPSENSE_ISR_US);
+
+    script = s;
+    script_start = MS(SCRIPT_START_MS) + SIM_US(phase_us);
+    next_event = 0u;
+    sim_gesture_source = gesture_source;
+    sim_touch_source = touch_source;
+    sim_sleep_hook = sleep_hook;
+
+    sim_run(firmware_main, script_start + MS(SCRIPT_LENGTH_MS));
+}
+
+static void test_loop(void)
+{
+    latency_t lat;
+    uint32_t i;
+    uint32_t phase;
+    uint32_t ticks;
+    double frames;
+    double frame_latency;
+    double bound;
+    uint32_t failed = 0u;
+
+    reset_latency(&lat);
+
+    /* The LED task may be deferred by up to LED_TASK_DEADLINE frames */
+    frames = (double)(LED_TASK_DEADLINE + 1u);
+
+    for (i = 0u; i < SCRIPT_COUNT; i++)
+    {
+        for (phase = 0u; phase < PHASE_RANGE_US; phase += PHASE_STEP_US)
+        {
+            replay_loop(&scripts[i], phase);
+            if ((0u == check_replay(&scripts[i], &lat, 1u, frames * FRAME_US)) && (0u == failed))
+            {
+                printf("  main loop: %s failed at phase %u us\n", scripts[i].name, (unsigned)phase);
+                failed = 1u;
+            }
+        }
+    }
+
+    printf("  %-18s", "main loop");
+    for (i = 0u; i < TYPE_COUNT; i++)
+    {
+        printf(" %8.1f", lat.confirmMax[i] / 1000.0);
+    }
+    printf(" %8.1f\n", lat.releaseMax / 1000.0);
+
+    /* A gesture is reported by the frame scanned after it, once the scan, the
+     * processing and the decoding are done */
+    frame_latency = FRAME_US + SIM_SCAN_TIME_US + PROCESS_US + GESTURE_US + TUNER_US + CAPSENSE_ISR_US;
+
+    /* As in the direct replay at the SysTick granularity. The ticks missed in
+     * Deep Sleep are caught up at the wake-up of the next frame */
+    ticks = (DOUBLE_CLICK_TIMEOUT / TIMESTAMP_INTERVAL_IN_MILSEC) + 1u;
+    bound = ((double)ticks * TIMESTAMP_INTERVAL_IN_MILSEC * 1000.0) + FRAME_US + frame_latency;
+    SIM_CHECK(lat.confirmMax[TYPE_SINGLE_CLICK] <= bound);
+    SIM_CHECK(lat.confirmMin[TYPE_SINGLE_CLICK] > (double)DOUBLE_CLICK_TIMEOUT * 1000.0 -
+                                                  TIMESTAMP_INTERVAL_IN_MILSEC * 1000.0);
+
+    /* The other gestures are held in the frame reporting them, at the earliest once its decoding is done */
+    for (i = TYPE_DOUBLE_CLICK; i < TYPE_COUNT; i++)
+    {
+        SIM_CHECK(lat.heldMax[i] < FRAME_US);
+        SIM_CHECK(lat.confirmMin[i] > 0.0);
+        SIM_CHECK(lat.confirmMax[i] <= frame_latency);
+    }
+
+    ticks = (LED_TIMEOUT_IN_MILSEC + TIMESTAMP_INTERVAL_IN_MILSEC - 1u) / TIMESTAMP_INTERVAL_IN_MILSEC;
+    bound = ((double)ticks * TIMESTAMP_INTERVAL_IN_MILSEC * 1000.0) + FRAME_US;
+    SIM_CHECK(lat.releaseMax <= bound);
+}
+
+int main(void)
+{
+    uint32_t i;
+
+    printf("Worst case gesture confirmation latency in ms, from the scripted gesture\n");
+    printf("  %-18s", "timer granularity");
+    for (i = 0u; i < TYPE_COUNT; i++)
+    {
+        printf(" %8s", type_names[i]);
+    }
+    printf(" %8s\n", "release");
+
+    test_direct(1u, "1 ms");
+    test_direct(10u, "10 ms");
+    test_direct(TIMESTAMP_INTERVAL_IN_MILSEC, "SysTick interval");
+    test_loop();
+
+    return sim_report("test_gesture_timing");
+}
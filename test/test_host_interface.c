@@ -0,0 +1,59 @@
+/******************************************************************************
+* File Name: test_host_interface.c
+*
+* Description: Tests of the HOST_INTERFACE header read by the host on the EZI2C
+* secondary slave address: version, size and feature mask of the present
+* blocks, also with the Tuner disabled, and Deep Sleep with the EZI2C slave
+* started only for the host interface and the WDT off by default.
+*
+*******************************************************************************/
+#include "sim.h"
+
+#define main firmware_main
+#include "main.c"
+#undef main
+#include "firmware_reset.h"
+
+static void test_header(void)
+{
+    HOST_INTERFACE_HEADER header;
+
+    firmware_reset();
+    sim_run(firmware_main, SIM_US(100000u));
+
+    SIM_CHECK(sizeof(host_interface) == sim_ezi2c_buffer_size(SIM_EZI2C_BUFFER2));
+
+    sim_host_read(SIM_EZI2C_BUFFER2, 0u, &header, sizeof(header));
+    SIM_CHECK(HOST_INTERFACE_VERSION == header.version);
+    SIM_CHECK(sizeof(host_interface) == header.size);
+    SIM_CHECK((HOST_FEATURE_TELEMETRY | HOST_FEATURE_MULTI_TOUCH | HOST_FEATURE_POSITION_FILTER |
+               HOST_FEATURE_SLEEP_MANAGER) == header.features);
+
+    /* The blocks follow the header in the order of the feature bits */
+    SIM_CHECK(offsetof(HOST_INTERFACE, telemetry) >= sizeof(HOST_INTERFACE_HEADER));
+    SIM_CHECK(offsetof(HOST_INTERFACE, touchReport) > offsetof(HOST_INTERFACE, telemetry));
+    SIM_CHECK(offsetof(HOST_INTERFACE, positionReport) > offsetof(HOST_INTERFACE, touchReport));
+    SIM_CHECK(offsetof(HOST_INTERFACE, sleepReport) > offsetof(HOST_INTERFACE, positionReport));
+}
+
+/* The EZI2C Deep Sleep callback is needed without the Tuner; the device model
+ * stops the run on a Deep Sleep entry with the EZI2C enabled and no callback */
+static void test_deep_sleep(void)
+{
+    firmware_reset();
+    sim_run(firmware_main, SIM_US(20000000u));
+
+    SIM_CHECK(0u != sim_power_stats.deepSleepCount);
+
+    /* The WDT, a reset source, only runs with ENABLE_ILO_TIMEBASE */
+    SIM_CHECK(0u == sim_wdt_is_enabled());
+    SIM_CHECK(0u == host_interface.telemetry.wotTimebaseWakeups);
+}
+
+int main(void)
+{
+    test_header();
+    test_deep_sleep();
+
+    return sim_report("test_host_interface");
+}
@@ -0,0 +1,142 @@
+/******************************************************************************
+* File Name: test_idle_scheduler.c
+*
+* Description: Tests of the idle-time task scheduler (ENABLE_IDLE_TASK_SCHEDULER)
+* driven frame by frame: a task that never fits in the time left by a higher
+* priority task runs on its deadline, and the time the Tuner task waits in the
+* suspend loop does not raise its cost estimate.
+*
+*******************************************************************************/
+#include <stdio.h>
+#include "sim.h"
+
+#define main firmware_main
+#include "main.c"
+#undef main
+#include "firmware_reset.h"
+
+#define FRAME_BUDGET_US         (2000u)
+#define FRAME_PROCESS_US        (500u)
+
+/* Leaves 50 us of the frame, less than the cost of the deferred task */
+#define FILLER_US               (FRAME_BUDGET_US - FRAME_PROCESS_US - 50u)
+#define DEFERRED_US             (100u)
+#define DEFERRED_DEADLINE       (4u)
+
+#define SUSPEND_LOOP_US         (1000u)
+#define SUSPEND_LOOPS           (30u)
+
+#define COMMON_OFFSET(member)   (offsetof(cy_stc_capsense_tuner_t, commonContext) + \
+                                 offsetof(cy_stc_capsense_common_context_t, member))
+
+static uint32_t frame;
+static uint32_t deferred_runs;
+static uint32_t deferred_last_frame;
+static uint32_t deferred_max_gap;
+static uint32_t suspend_loops;
+
+static void filler_task(void)
+{
+    sim_advance(SIM_US(FILLER_US));
+}
+
+static void deferred_task(void)
+{
+    sim_advance(SIM_US(DEFERRED_US));
+    deferred_max_gap = CY_MAX(deferred_max_gap, frame - deferred_last_frame);
+    deferred_last_frame = frame;
+    deferred_runs++;
+}
+
+/* Processes one frame and runs the tasks in the time left */
+static void run_frame(void)
+{
+    frame++;
+    frame_start_tick = Cy_SysTick_GetValue();
+    sim_advance(SIM_US(FRAME_PROCESS_US));
+    run_idle_tasks(FRAME_BUDGET_US, FRAME_PROCESS_US);
+}
+
+static void setup(void)
+{
+    firmware_reset();
+    __enable_irq();
+    init_sys_tick();
+    frame = 0u;
+}
+
+/* The deferred task never fits after the filler, it runs once overdue by its deadline */
+static void test_deadline(void)
+{
+    uint32_t i;
+
+    setup();
+    deferred_runs = 0u;
+    deferred_last_frame = 0u;
+    deferred_max_gap = 0u;
+    register_idle_task(filler_task, 1u, 100u, FILLER_US);
+    register_idle_task(deferred_task, 1u, DEFERRED_DEADLINE, DEFERRED_US);
+
+    for (i = 0u; i < 50u; i++)
+    {
+        run_frame();
+    }
+
+    printf("  deferred task: %u runs in %u frames, longest interval %u frames\n", (unsigned)deferred_runs,
+           (unsigned)frame, (unsigned)deferred_max_gap);
+    SIM_CHECK(deferred_runs >= (frame / (1u + DEFERRED_DEADLINE)));
+    SIM_CHECK(deferred_max_gap <= (1u + DEFERRED_DEADLINE));
+}
+
+/* The host resumes the scanning after SUSPEND_LOOPS iterations of the suspend loop */
+static void suspend_host(void)
+{
+    uint16_t resume = CY_CAPSENSE_TU_CMD_RESUME_E;
+
+    sim_advance(SIM_US(SUSPEND_LOOP_US));
+    if (++suspend_loops == SUSPEND_LOOPS)
+    {
+        sim_host_write(SIM_EZI2C_BUFFER1, COMMON_OFFSET(tunerCmd), &resume, sizeof(resume));
+    }
+}
+
+/* A suspend keeps the cost estimate of the Tuner task */
+static void test_suspend_not_sampled(void)
+{
+    uint16_t suspend = CY_CAPSENSE_TU_CMD_SUSPEND_E;
+    uint16_t cost;
+    uint32_t i;
+
+    setup();
+    sim_tuner_cycles = SIM_US(40u);
+    initialize_capsense_tuner();
+    initialize_capsense();
+    register_idle_task(tuner_task, TUNER_TASK_PERIOD, TUNER_TASK_DEADLINE, TUNER_TASK_COST);
+
+    for (i = 0u; i < 50u; i++)
+    {
+        run_frame();
+    }
+    cost = idle_tasks[0].cost;
+
+    suspend_loops = 0u;
+    sim_host_write(SIM_EZI2C_BUFFER1, COMMON_OFFSET(tunerCmd), &suspend, sizeof(suspend));
+    sim_tuner_loop_hook = suspend_host;
+    run_frame();
+    sim_tuner_loop_hook = NULL;
+
+    printf("  Tuner task cost: %u us before, %u us after a %u ms suspend\n", (unsigned)cost,
+           (unsigned)idle_tasks[0].cost, (unsigned)(SUSPEND_LOOPS * SUSPEND_LOOP_US / 1000u));
+    SIM_CHECK(suspend_loops >= SUSPEND_LOOPS);
+    SIM_CHECK(CY_CAPSENSE_TU_FSM_RUNNING == cy_capsense_tuner.commonContext.tunerSt);
+    SIM_CHECK(cost < 100u);
+    SIM_CHECK(cost == idle_tasks[0].cost);
+}
+
+int main(void)
+{
+    test_deadline();
+    test_suspend_not_sampled();
+
+    return sim_report("test_idle_scheduler");
+}
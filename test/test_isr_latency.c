@@ -0,0 +1,74 @@
+/******************************************************************************
+* File Name: test_isr_latency.c
+*
+* Description: Tests of the interrupt latency report (ENABLE_ISR_LATENCY) with
+* the firmware main loop: the CPU wake-up to ISR entry time is counted only
+* for the interrupts that woke up the CPU, not for the ones raised later while
+* the frame is processed.
+*
+*******************************************************************************/
+#include "sim.h"
+
+#define main firmware_main
+#include "main.c"
+#undef main
+#include "firmware_reset.h"
+
+/* Host read period, not a multiple of the frame period so the reads fall both
+ * in the idle time and in the frame processing */
+#define HOST_READ_PERIOD_US     (3100u)
+
+static uint8_t host_data[8];
+static uint32_t host_reads;
+
+static void host_read_event(void *arg)
+{
+    (void)arg;
+    sim_host_read(SIM_EZI2C_BUFFER2, 0u, host_data, sizeof(host_data));
+    host_reads++;
+    sim_schedule(sim_now() + SIM_US(HOST_READ_PERIOD_US), host_read_event, NULL);
+}
+
+static uint32_t histogram_count(volatile LATENCY_HISTOGRAM *ptrHistogram)
+{
+    uint32_t count = 0u;
+    uint32_t i;
+
+    for (i = 0u; i < LATENCY_HISTOGRAM_BUCKETS; i++)
+    {
+        count += ptrHistogram->count[i];
+    }
+    return count;
+}
+
+static void test_wake_to_isr(void)
+{
+    volatile LATENCY_REPORT *ptrReport = &host_interface.latencyReport;
+
+    firmware_reset();
+    host_reads = 0u;
+
+    /* Long enough processing for the host reads to fall in it */
+    sim_process_cycles = SIM_US(1500u);
+    sim_schedule(SIM_US(HOST_READ_PERIOD_US), host_read_event, NULL);
+
+    sim_run(firmware_main, SIM_US(2000000u));
+
+    /* The CPU wakes up for every frame and for the host reads in the idle time */
+    SIM_CHECK(histogram_count(&ptrReport->capsenseWakeToIsr) > 0u);
+    SIM_CHECK(histogram_count(&ptrReport->ezi2cWakeToIsr) > 0u);
+
+    /* Reads during the processing are not wake-ups */
+    SIM_CHECK(histogram_count(&ptrReport->ezi2cWakeToIsr) < host_reads);
+
+    /* The model takes the pending interrupts right after the wake-up */
+    SIM_CHECK(ptrReport->capsenseWakeToIsr.max < LATENCY_BUCKET_WIDTH);
+    SIM_CHECK(ptrReport->ezi2cWakeToIsr.max < LATENCY_BUCKET_WIDTH);
+}
+
+int main(void)
+{
+    test_wake_to_isr();
+
+    return sim_report("test_isr_latency");
+}
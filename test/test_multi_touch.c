@@ -0,0 +1,190 @@
+/******************************************************************************
+* File Name: test_multi_touch.c
+*
+* Description: Tests of the two-finger tracking (ENABLE_MULTI_TOUCH) with the
+* firmware main loop: every frame of the multi-touch report is checked as the
+* host reads it. Two fingers crossing each other keep their IDs also when the
+* scan reports them in a different order every frame, and a finger held while
+* the other one taps more than 255 times keeps an ID no other contact gets.
+*
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include "sim.h"
+
+#define main firmware_main
+#include "main.c"
+#undef main
+#include "firmware_reset.h"
+
+#define TOUCH_START_US          (500000u)
+#define CROSS_TIME_US           (1000000u)
+#define TAP_COUNT               (300u)
+#define TAP_ON_US               (24000u)
+#define TAP_PERIOD_US           (48000u)
+
+#define HELD_X                  (60u)
+#define HELD_Y                  (60u)
+#define TAP_X                   (200u)
+#define TAP_Y                   (200u)
+
+/* Checks of the reported frames */
+typedef struct
+{
+    uint32_t frames;
+    uint32_t touchdowns;
+    uint32_t liftoffs;
+    uint32_t errors;
+    uint8_t heldId;             /* ID of the first contact, the held or the lower finger */
+    uint32_t heldIdChanges;
+} report_check_t;
+
+static report_check_t check;
+static uint32_t last_sequence;
+
+/* Two fingers crossing in x at y 60 and 190, reported in a different order every frame */
+static uint32_t cross_source(uint64_t time, sim_touch_t *touches)
+{
+    uint32_t t;
+    uint32_t first;
+
+    if ((time < SIM_US(TOUCH_START_US)) || (time >= SIM_US(TOUCH_START_US + CROSS_TIME_US)))
+    {
+        return 0u;
+    }
+    t = (uint32_t)((time - SIM_US(TOUCH_START_US)) / SIM_CYCLES_PER_US);
+    first = sim_frame_count & 1u;
+
+    touches[first].x = (uint16_t)(40u + ((170u * (uint64_t)t) / CROSS_TIME_US));
+    touches[first].y = 60u;
+    touches[first].z = 400u;
+    touches[1u - first].x = (uint16_t)(210u - ((170u * (uint64_t)t) / CROSS_TIME_US));
+    touches[1u - first].y = 190u;
+    touches[1u - first].z = 300u;
+    return 2u;
+}
+
+/* One finger held while the other one taps TAP_COUNT times */
+static uint32_t tap_source(uint64_t time, sim_touch_t *touches)
+{
+    uint64_t t;
+
+    if ((time < SIM_US(TOUCH_START_US)) || (time >= SIM_US(TOUCH_START_US + (TAP_COUNT + 1u) * TAP_PERIOD_US)))
+    {
+        return 0u;
+    }
+    touches[0].x = HELD_X;
+    touches[0].y = HELD_Y;
+    touches[0].z = 400u;
+
+    t = (time - SIM_US(TOUCH_START_US)) / SIM_CYCLES_PER_US;
+    if ((t >= TAP_PERIOD_US) && ((t % TAP_PERIOD_US) < TAP_ON_US))
+    {
+        touches[1].x = TAP_X;
+        touches[1].y = TAP_Y;
+        touches[1].z = 300u;
+        return 2u;
+    }
+    return 1u;
+}
+
+/* Checks each new frame of the report: IDs unique among the contacts, a
+ * touchdown for every new ID and the flags of the lower finger */
+static void check_report(void)
+{
+    const volatile TOUCH_REPORT *ptrReport = &host_interface.touchReport;
+    const volatile TOUCH_CONTACT *ptrContact;
+    uint32_t i;
+    uint32_t k;
+    uint8_t lowerId = 0u;
+
+    if ((ptrReport->sequence == last_sequence) || (0u != (ptrReport->sequence & 1u)))
+    {
+        return;
+    }
+    last_sequence = ptrReport->sequence;
+    check.frames++;
+
+    for (i = 0u; i < MULTI_TOUCH_MAX_CONTACTS; i++)
+    {
+        ptrContact = &ptrReport->contact[i];
+        if (0u == ptrContact->id)
+        {
+            continue;
+        }
+        for (k = i + 1u; k < MULTI_TOUCH_MAX_CONTACTS; k++)
+        {
+            if (ptrContact->id == ptrReport->contact[k].id)
+            {
+                check.errors++;
+            }
+        }
+        check.touchdowns += (0u != (ptrContact->flags & CONTACT_FLAG_TOUCHDOWN)) ? 1u : 0u;
+        check.liftoffs += (0u != (ptrContact->flags & CONTACT_FLAG_LIFTOFF)) ? 1u : 0u;
+
+        /* The finger at y 60, the lower one of both scenarios, keeps the ID of its touchdown */
+        if ((ptrContact->y < 128u) && (0u == (ptrContact->flags & CONTACT_FLAG_LIFTOFF)))
+        {
+            lowerId = ptrContact->id;
+            check.errors += (400u != ptrContact->pressure) ? 1u : 0u;
+        }
+    }
+
+    if (0u != lowerId)
+    {
+        if ((0u != check.heldId) && (lowerId != check.heldId))
+        {
+            check.heldIdChanges++;
+        }
+        check.heldId = lowerId;
+    }
+}
+
+static void run_touches(uint32_t (*source)(uint64_t time, sim_touch_t *touches), uint64_t until)
+{
+    firmware_reset();
+    memset(&check, 0, sizeof(check));
+    last_sequence = 0u;
+    sim_touch_source = source;
+    sim_sleep_hook = check_report;
+
+    sim_run(firmware_main, until);
+}
+
+/* The closest pairs are matched, so the IDs follow the fingers whatever the order of the touches */
+static void test_crossing(void)
+{
+    run_touches(cross_source, SIM_US(TOUCH_START_US + CROSS_TIME_US + 100000u));
+
+    printf("  crossing fingers: %u frames, %u touchdowns, %u liftoffs, %u ID changes, %u errors\n",
+           (unsigned)check.frames, (unsigned)check.touchdowns, (unsigned)check.liftoffs,
+           (unsigned)check.heldIdChanges, (unsigned)check.errors);
+    SIM_CHECK(check.frames > (CROSS_TIME_US / (TIME_IN_US / ACTIVE_MODE_REFRESH_RATE)));
+    SIM_CHECK(2u == check.touchdowns);
+    SIM_CHECK(2u == check.liftoffs);
+    SIM_CHECK(0u == check.heldIdChanges);
+    SIM_CHECK(0u == check.errors);
+    SIM_CHECK(0u == host_interface.touchReport.numContacts);
+}
+
+/* The IDs wrap after 255 touchdowns and skip the ID of the held finger */
+static void test_id_wrap(void)
+{
+    run_touches(tap_source, SIM_US(TOUCH_START_US + (TAP_COUNT + 1u) * TAP_PERIOD_US + 100000u));
+
+    printf("  %u taps beside a held finger: %u touchdowns, %u liftoffs, %u ID changes, %u errors\n",
+           (unsigned)TAP_COUNT, (unsigned)check.touchdowns, (unsigned)check.liftoffs,
+           (unsigned)check.heldIdChanges, (unsigned)check.errors);
+    SIM_CHECK((TAP_COUNT + 1u) == check.touchdowns);
+    SIM_CHECK((TAP_COUNT + 1u) == check.liftoffs);
+    SIM_CHECK(0u == check.heldIdChanges);
+    SIM_CHECK(0u == check.errors);
+}
+
+int main(void)
+{
+    test_crossing();
+    test_id_wrap();
+
+    return sim_report("test_multi_touch");
+}
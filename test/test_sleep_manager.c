@@ -0,0 +1,158 @@
+/******************************************************************************
+* File Name: test_sleep_manager.c
+*
+* Description: Tests of the sleep manager (ENABLE_SLEEP_MANAGER) with the
+* firmware main loop and the LED PWMs enabled: Deep Sleep in ACTIVE mode while
+* the LEDs are off, CPU Sleep for the wake-ups near the end of the idle period
+* predicted with the ILO timebase, also with an ILO off its nominal frequency,
+* and the gesture timestamp kept in time across Deep Sleep.
+*
+*******************************************************************************/
+#include <stdio.h>
+#include "sim.h"
+
+#define main firmware_main
+#include "main.c"
+#undef main
+#include "firmware_reset.h"
+
+#define MS(ms)                  SIM_US((uint64_t)(ms) * 1000u)
+
+/* Touch in ACTIVE mode, then the host reads in the ACTIVE time left after the liftoff */
+#define TOUCH_START             MS(500u)
+#define TOUCH_END               MS(1500u)
+#define READS_START             MS(2000u)
+#define READS_END               MS(3000u)
+#define RUN_END                 MS(4000u)
+
+/* Host reads this long before the end of the idle period, and in the middle of it */
+#define READ_BEFORE_END_US      (30u)
+
+typedef struct
+{
+    uint32_t deepSleepCount;
+    uint32_t sleepCount;
+} sleep_counts_t;
+
+static sleep_counts_t touch_start_counts;
+static sleep_counts_t touch_end_counts;
+static sleep_counts_t reads_start_counts;
+static sleep_counts_t reads_end_counts;
+static uint64_t last_scan_start;
+static uint32_t late_reads;
+static uint32_t mid_reads;
+static uint8_t host_data[4];
+
+static uint32_t touch_source(uint64_t time, sim_touch_t *touches)
+{
+    if ((time >= TOUCH_START) && (time < TOUCH_END))
+    {
+        touches[0].x = 128u;
+        touches[0].y = 100u;
+        touches[0].z = 100u;
+        return 1u;
+    }
+    return 0u;
+}
+
+static void late_read_event(void *arg)
+{
+    (void)arg;
+    sim_host_read(SIM_EZI2C_BUFFER2, 0u, host_data, sizeof(host_data));
+    late_reads++;
+}
+
+static void mid_read_event(void *arg)
+{
+    (void)arg;
+    sim_host_read(SIM_EZI2C_BUFFER2, 0u, host_data, sizeof(host_data));
+    mid_reads++;
+}
+
+static void sample_counts(sleep_counts_t *ptrCounts, uint64_t time)
+{
+    if ((sim_now() >= time) && (0u == ptrCounts->deepSleepCount) && (0u == ptrCounts->sleepCount))
+    {
+        ptrCounts->deepSleepCount = host_interface.sleepReport.deepSleepCount;
+        ptrCounts->sleepCount = host_interface.sleepReport.sleepCount;
+    }
+}
+
+/* Called before every low power entry of the firmware */
+static void sleep_hook(void)
+{
+    sample_counts(&touch_start_counts, TOUCH_START + MS(100u));
+    sample_counts(&touch_end_counts, TOUCH_END);
+    sample_counts(&reads_start_counts, READS_START);
+    sample_counts(&reads_end_counts, READS_END);
+
+    /* Two host reads in the idle period of every frame scanned in the read interval */
+    if ((sim_scan_start_time != last_scan_start) && (sim_scan_start_time >= READS_START) &&
+        (sim_scan_start_time < READS_END))
+    {
+        last_scan_start = sim_scan_start_time;
+        sim_schedule(sim_scan_start_time + SIM_US(ACTIVE_MODE_IDLE_WINDOW / 2u), mid_read_event, NULL);
+        sim_schedule(sim_scan_start_time + SIM_US(ACTIVE_MODE_IDLE_WINDOW - READ_BEFORE_END_US),
+                     late_read_event, NULL);
+    }
+}
+
+static void run(uint32_t ilo_freq)
+{
+    firmware_reset();
+    memset(&touch_start_counts, 0, sizeof(touch_start_counts));
+    memset(&touch_end_counts, 0, sizeof(touch_end_counts));
+    memset(&reads_start_counts, 0, sizeof(reads_start_counts));
+    memset(&reads_end_counts, 0, sizeof(reads_end_counts));
+    last_scan_start = 0u;
+    late_reads = 0u;
+    mid_reads = 0u;
+
+    sim_ilo_freq = ilo_freq;
+    sim_touch_source = touch_source;
+    sim_sleep_hook = sleep_hook;
+
+    sim_run(firmware_main, RUN_END);
+}
+
+static void test_sleep_modes(const char *name, uint32_t ilo_freq)
+{
+    uint32_t touch_deep_sleeps;
+    uint32_t deep_sleeps;
+    uint32_t sleeps;
+    uint32_t timestamp;
+
+    run(ilo_freq);
+
+    touch_deep_sleeps = touch_end_counts.deepSleepCount - touch_start_counts.deepSleepCount;
+    deep_sleeps = reads_end_counts.deepSleepCount - reads_start_counts.deepSleepCount;
+    sleeps = reads_end_counts.sleepCount - reads_start_counts.sleepCount;
+    timestamp = cy_capsense_context.ptrCommonContext->timestamp;
+
+    printf("  %-12s touch: %u deep sleeps; reads: %u late, %u mid, %u sleeps, %u deep sleeps; "
+           "timestamp %u ms at %u ms\n", name, (unsigned)touch_deep_sleeps, (unsigned)late_reads,
+           (unsigned)mid_reads, (unsigned)sleeps, (unsigned)deep_sleeps, (unsigned)timestamp,
+           (unsigned)(sim_now() / MS(1u)));
+
+    /* LEDs on: CPU Sleep only */
+    SIM_CHECK(0u == touch_deep_sleeps);
+
+    /* LEDs off: Deep Sleep at the frame start and after the reads in the middle of the period,
+     * CPU Sleep after the reads near its end */
+    SIM_CHECK(late_reads > 100u);
+    SIM_CHECK(sleeps >= late_reads);
+    SIM_CHECK(deep_sleeps >= (2u * mid_reads));
+
+    /* The gesture timestamp follows the time within two SysTick intervals */
+    SIM_CHECK((timestamp + (2u * TIMESTAMP_INTERVAL_IN_MILSEC)) >= (uint32_t)(sim_now() / MS(1u)));
+    SIM_CHECK(timestamp <= ((uint32_t)(sim_now() / MS(1u)) + (2u * TIMESTAMP_INTERVAL_IN_MILSEC)));
+}
+
+int main(void)
+{
+    test_sleep_modes("nominal ILO", SIM_ILO_FREQ);
+    test_sleep_modes("ILO +30 %", (SIM_ILO_FREQ * 13u) / 10u);
+    test_sleep_modes("ILO -30 %", (SIM_ILO_FREQ * 7u) / 10u);
+
+    return sim_report("test_sleep_manager");
+}
@@ -0,0 +1,98 @@
+/******************************************************************************
+* File Name: test_telemetry.c
+*
+* Description: Tests of the power state telemetry (ENABLE_TELEMETRY) with the
+* firmware main loop running against the device model: the WOT state time
+* includes the WOT frames ended by a touch, measured with the ILO timebase and
+* calibrated by the frames ended by the timeout, also with an ILO off its
+* nominal frequency, and the CPU wake-ups in WOT mode by the timebase are
+* counted.
+*
+*******************************************************************************/
+#include <stdio.h>
+#include "sim.h"
+
+#define main firmware_main
+#include "main.c"
+#undef main
+#include "firmware_reset.h"
+
+#define SECONDS(s)          SIM_US((uint64_t)(s) * 1000000u)
+
+/* One touch in the middle of the touchpad during the given interval */
+static uint64_t touch_start;
+static uint64_t touch_end;
+
+static uint32_t touch_source(uint64_t time, sim_touch_t *touches)
+{
+    if ((time >= touch_start) && (time < touch_end))
+    {
+        touches[0].x = 128u;
+        touches[0].y = 128u;
+        touches[0].z = 100u;
+        return 1u;
+    }
+    return 0u;
+}
+
+/* Runs the firmware from reset with a touch at the given time, then returns the
+ * WOT time accounted by the telemetry in us */
+static uint64_t run_wot_touch(uint32_t ilo_freq, uint64_t touch_at, uint64_t until)
+{
+    firmware_reset();
+    sim_ilo_freq = ilo_freq;
+    sim_touch_source = touch_source;
+    touch_start = touch_at;
+    touch_end = touch_at + SECONDS(1);
+
+    sim_run(firmware_main, until);
+
+    return host_interface.telemetry.stateTime[TELEMETRY_STATE_INDEX(WOT_MODE)];
+}
+
+static void check_wot_time(const char *name, uint64_t measured_us, uint64_t tolerance_us)
+{
+    uint64_t actual_us = sim_wot_cycles / SIM_CYCLES_PER_US;
+    uint64_t error_us = (measured_us > actual_us) ? (measured_us - actual_us) : (actual_us - measured_us);
+
+    printf("  %-36s actual %10llu us, accounted %10llu us\n", name,
+           (unsigned long long)actual_us, (unsigned long long)measured_us);
+    SIM_CHECK(error_us <= tolerance_us);
+}
+
+/* The timebase interrupt wakes the CPU every wrap of the 16-bit WDT counter */
+static void check_wot_wakeups(void)
+{
+    uint64_t wrap_cycles = ((uint64_t)SIM_CYCLES_PER_US * 1000000u << WDT_COUNTER_BITS) / sim_ilo_freq;
+    uint32_t expected = (uint32_t)(sim_wot_cycles / wrap_cycles);
+    uint32_t wakeups = host_interface.telemetry.wotTimebaseWakeups;
+
+    printf("  %-36s %u in %llu ms of WOT, %u expected\n", "timebase wake-ups", (unsigned)wakeups,
+           (unsigned long long)(sim_wot_cycles / SIM_CYCLES_PER_US / 1000u), (unsigned)expected);
+    SIM_CHECK((wakeups + 1u >= expected) && (wakeups <= expected + 1u));
+}
+
+int main(void)
+{
+    uint64_t wot_us;
+
+    /* ACTIVE 10 s, ALR 5 s, WOT timeout at 25 s, ALR 5 s, WOT from 30 s ended by the touch at 36 s */
+    wot_us = run_wot_touch(SIM_ILO_FREQ, SECONDS(36), SECONDS(38));
+    SIM_CHECK(2u == sim_wot_count);
+    SIM_CHECK(0u != host_interface.telemetry.wotTimeoutIloTicks);
+    check_wot_time("nominal ILO", wot_us, 2000u);
+    check_wot_wakeups();
+
+    /* ILO 20 % fast: the time of the WOT frame ended by the touch is calibrated by the timeout */
+    wot_us = run_wot_touch(SIM_ILO_FREQ * 6u / 5u, SECONDS(36), SECONDS(38));
+    SIM_CHECK(2u == sim_wot_count);
+    check_wot_time("ILO +20 %, calibrated", wot_us, 2000u);
+
+    /* Touch in the first WOT frame, before any calibration: the nominal ILO frequency is used */
+    wot_us = run_wot_touch(SIM_ILO_FREQ, SECONDS(20), SECONDS(22));
+    SIM_CHECK(1u == sim_wot_count);
+    SIM_CHECK(0u == host_interface.telemetry.wotTimeoutIloTicks);
+    check_wot_time("nominal ILO, not calibrated", wot_us, 2000u);
+
+    return sim_report("test_telemetry");
+}
@@ -0,0 +1,306 @@
+/******************************************************************************
+* File Name: test_touchpad_batch.c
+*
+* Description: Bit-exact check and throughput of the host batch library in
+* ../host against the specialized touchpad processing of the firmware
+* (update_touchpad_status() in main.c). Generated captures with moving
+* fingers, noise, plateaus, values around the thresholds and full range
+* difference counts are processed frame by frame by the firmware code and in
+* batches by the library, with several thresholds and thread counts, and in
+* parts with the status carried between the calls. Every frame must give the
+* same touch status, debounce, touch count and positions. The frames per
+* second of both are printed. The generic processing of the middleware is not
+* involved: the library reproduces the specialized path only.
+*
+* Usage: run [frames]
+* The default is 200000 frames per capture.
+*
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "sim.h"
+#include "touchpad_batch.h"
+
+#define main firmware_main
+#include "main.c"
+#undef main
+#include "firmware_reset.h"
+
+#define DEFAULT_FRAMES              (200000u)
+#define SEGMENT_FRAMES              (64u)
+
+typedef struct
+{
+    const char *name;
+    touchpad_batch_config_t config;
+} capture_config_t;
+
+/* The configured thresholds, a threshold below the hysteresis, and thresholds without hysteresis or debounce */
+static const capture_config_t configs[] =
+{
+    { "configured", { CY_CAPSENSE_TOUCHPAD_FINGER_TH, CY_CAPSENSE_TOUCHPAD_HYSTERESIS, CY_CAPSENSE_TOUCHPAD_ON_DEBOUNCE } },
+    { "threshold 0", { 40u, 50u, 1u } },
+    { "no hysteresis", { 2000u, 0u, 1u } },
+    { "high", { 65000u, 255u, 2u } },
+};
+
+#define CONFIG_COUNT                (sizeof(configs) / sizeof(configs[0]))
+
+static uint32_t random_state = 12345u;
+
+static uint32_t next_random(void)
+{
+    random_state = (random_state * 1103515245u) + 12345u;
+    return random_state >> 8u;
+}
+
+static uint16_t random_range(uint32_t low, uint32_t high)
+{
+    return (uint16_t)(low + (next_random() % (high - low + 1u)));
+}
+
+/* Adds a finger at x, y in node pitches with the given peak to the frame */
+static void add_finger(touchpad_batch_frame_t frame, double x, double y, double peak)
+{
+    uint32_t col;
+    uint32_t row;
+    double dist;
+    double value;
+
+    for (col = 0u; col < TOUCHPAD_BATCH_NUM_COLS; col++)
+    {
+        for (row = 0u; row < TOUCHPAD_BATCH_NUM_ROWS; row++)
+        {
+            dist = ((col - x) * (col - x)) + ((row - y) * (row - y));
+            value = peak * (1.0 - (dist / (1.35 * 1.35)));
+            if (value > 0.0)
+            {
+                value += frame[(col * TOUCHPAD_BATCH_NUM_ROWS) + row];
+                frame[(col * TOUCHPAD_BATCH_NUM_ROWS) + row] = (uint16_t)((value < 65535.0) ? value : 65535.0);
+            }
+        }
+    }
+}
+
+/* Segments of frames alternating noise, one or two moving fingers, plateaus
+ * of equal values, values around the thresholds, and full range values */
+static void generate_capture(touchpad_batch_frame_t *frames, uint32_t count, const touchpad_batch_config_t *config)
+{
+    uint32_t kind = 0u;
+    uint32_t i;
+    uint32_t n;
+    double t;
+    double peak = 0.0;
+
+    for (i = 0u; i < count; i++)
+    {
+        if (0u == (i % SEGMENT_FRAMES))
+        {
+            kind = next_random() % 6u;
+            peak = (double)random_range(config->fingerTh / 2u, 2u * (uint32_t)config->fingerTh + 500u);
+        }
+        t = (double)(i % SEGMENT_FRAMES) / SEGMENT_FRAMES;
+
+        for (n = 0u; n < TOUCHPAD_BATCH_NUM_SNS; n++)
+        {
+            frames[i][n] = random_range(0u, 120u);
+        }
+
+        switch (kind)
+        {
+            case 1u:
+                add_finger(frames[i], -0.5 + (4.0 * t), 4.5 * t, peak);
+                break;
+
+            case 2u:
+                add_finger(frames[i], 3.0 * t, 1.0, peak);
+                add_finger(frames[i], 3.0 - (3.0 * t), 3.5, peak * 0.8);
+                break;
+
+            case 3u:
+                /* Equal values around a random node */
+                n = next_random() % TOUCHPAD_BATCH_NUM_SNS;
+                frames[i][n] = (uint16_t)peak;
+                frames[i][(n + 1u) % TOUCHPAD_BATCH_NUM_SNS] = (uint16_t)peak;
+                frames[i][(n + TOUCHPAD_BATCH_NUM_ROWS) % TOUCHPAD_BATCH_NUM_SNS] = (uint16_t)peak;
+                break;
+
+            case 4u:
+                for (n = 0u; n < TOUCHPAD_BATCH_NUM_SNS; n++)
+                {
+                    frames[i][n] = random_range((config->fingerTh > (config->hysteresis + 2u)) ?
+                                                (config->fingerTh - config->hysteresis - 2u) : 0u,
+                                                CY_MIN((uint32_t)config->fingerTh + config->hysteresis + 2u,
+                                                       UINT16_MAX));
+                }
+                break;
+
+            case 5u:
+                for (n = 0u; n < TOUCHPAD_BATCH_NUM_SNS; n++)
+                {
+                    frames[i][n] = random_range(0u, UINT16_MAX);
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+}
+
+static double seconds(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + ((double)now.tv_nsec * 1e-9);
+}
+
+/* Processes the frames one by one with the firmware code */
+static void process_firmware(const touchpad_batch_config_t *config, const touchpad_batch_frame_t *frames,
+                             uint32_t count, TOUCHPAD_STATUS *results)
+{
+    const cy_stc_capsense_widget_config_t *ptrWdCfg = &cy_capsense_context.ptrWdConfig[CY_CAPSENSE_TOUCHPAD_WDGT_ID];
+    TOUCHPAD_STATUS status;
+    uint32_t i;
+    uint32_t n;
+
+    ptrWdCfg->ptrWdContext->fingerTh = config->fingerTh;
+    ptrWdCfg->ptrWdContext->hysteresis = config->hysteresis;
+    ptrWdCfg->ptrWdContext->onDebounce = config->onDebounce;
+    memset(&status, 0, sizeof(status));
+
+    for (i = 0u; i < count; i++)
+    {
+        for (n = 0u; n < TOUCHPAD_BATCH_NUM_SNS; n++)
+        {
+            ptrWdCfg->ptrSnsContext[n].diff = frames[i][n];
+        }
+        update_touchpad_status(&status);
+        results[i] = status;
+    }
+}
+
+static uint32_t count_mismatches(const TOUCHPAD_STATUS *expected, const touchpad_batch_status_t *results,
+                                 uint32_t count)
+{
+    uint32_t mismatches = 0u;
+    uint32_t i;
+    uint32_t k;
+
+    for (i = 0u; i < count; i++)
+    {
+        if ((expected[i].active != results[i].active) || (expected[i].debounce != results[i].debounce) ||
+            (expected[i].numPosition != results[i].numPosition))
+        {
+            mismatches++;
+            continue;
+        }
+        for (k = 0u; k < expected[i].numPosition; k++)
+        {
+            if ((expected[i].position[k].x != results[i].position[k].x) ||
+                (expected[i].position[k].y != results[i].position[k].y) ||
+                (expected[i].position[k].z != results[i].position[k].z) ||
+                (expected[i].position[k].id != results[i].position[k].id))
+            {
+                mismatches++;
+                break;
+            }
+        }
+    }
+    return mismatches;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t frames_count = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : DEFAULT_FRAMES;
+    uint32_t max_threads = (uint32_t)sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t thread_counts[2] = { 1u, 4u };
+    touchpad_batch_frame_t *frames = malloc(frames_count * sizeof(touchpad_batch_frame_t));
+    TOUCHPAD_STATUS *expected = malloc(frames_count * sizeof(TOUCHPAD_STATUS));
+    touchpad_batch_status_t *results = malloc(frames_count * sizeof(touchpad_batch_status_t));
+    touchpad_batch_status_t state;
+    uint32_t touch_frames;
+    uint32_t mismatches;
+    uint32_t split;
+    uint32_t c;
+    uint32_t t;
+    uint32_t i;
+    double start;
+    double firmware_rate;
+    double rate[2];
+    char threads_label[24];
+
+    SIM_CHECK((NULL != frames) && (NULL != expected) && (NULL != results));
+    if ((NULL == frames) || (NULL == expected) || (NULL == results))
+    {
+        return sim_report("test_touchpad_batch");
+    }
+
+    /* The library is specialized for the same touchpad as the firmware */
+    SIM_CHECK(TOUCHPAD_BATCH_NUM_COLS == TOUCHPAD_NUM_COLS);
+    SIM_CHECK(TOUCHPAD_BATCH_NUM_ROWS == TOUCHPAD_NUM_ROWS);
+    SIM_CHECK(TOUCHPAD_BATCH_NUM_TOUCHES == CY_CAPSENSE_TOUCHPAD_NUM_TOUCHES);
+    SIM_CHECK(TOUCHPAD_BATCH_MAX_POSITION == TOUCHPAD_MAX_POSITION);
+
+    thread_counts[1] = CY_MAX(max_threads, 2u);
+    firmware_reset();
+
+    printf("Touchpad batch library vs firmware processing, %u frames per capture, frames/s\n",
+           (unsigned)frames_count);
+    snprintf(threads_label, sizeof(threads_label), "%u threads", (unsigned)thread_counts[1]);
+    printf("  %-14s %8s %12s %12s %12s %10s\n", "thresholds", "touch", "firmware", "1 thread", threads_label,
+           "mismatches");
+
+    for (c = 0u; c < CONFIG_COUNT; c++)
+    {
+        generate_capture(frames, frames_count, &configs[c].config);
+
+        start = seconds();
+        process_firmware(&configs[c].config, frames, frames_count, expected);
+        firmware_rate = frames_count / (seconds() - start);
+
+        touch_frames = 0u;
+        for (i = 0u; i < frames_count; i++)
+        {
+            touch_frames += (0u != expected[i].numPosition) ? 1u : 0u;
+        }
+
+        mismatches = 0u;
+        for (t = 0u; t < 2u; t++)
+        {
+            memset(&state, 0, sizeof(state));
+            memset(results, 0xA5, frames_count * sizeof(touchpad_batch_status_t));
+            start = seconds();
+            SIM_CHECK(0 == touchpad_batch_process(&configs[c].config, frames, frames_count, thread_counts[t],
+                                                  &state, results));
+            rate[t] = frames_count / (seconds() - start);
+            mismatches += count_mismatches(expected, results, frames_count);
+        }
+
+        /* In two parts split off a vector boundary, with the status carried between them */
+        split = (frames_count / 3u) | 1u;
+        split = CY_MIN(split, frames_count);
+        memset(&state, 0, sizeof(state));
+        SIM_CHECK(0 == touchpad_batch_process(&configs[c].config, frames, split, 3u, &state, results));
+        SIM_CHECK(0 == touchpad_batch_process(&configs[c].config, &frames[split], frames_count - split, 2u, &state,
+                                              &results[split]));
+        mismatches += count_mismatches(expected, results, frames_count);
+
+        printf("  %-14s %8u %12.0f %12.0f %12.0f %10u\n", configs[c].name, (unsigned)touch_frames, firmware_rate,
+               rate[0], rate[1], (unsigned)mismatches);
+
+        SIM_CHECK(0u == mismatches);
+        /* The generated captures have touches once they span a few segments */
+        SIM_CHECK((0u != touch_frames) || (frames_count < (16u * SEGMENT_FRAMES)));
+    }
+
+    free(frames);
+    free(expected);
+    free(results);
+
+    return sim_report("test_touchpad_batch");
+}
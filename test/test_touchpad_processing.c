@@ -0,0 +1,565 @@
+/******************************************************************************
+* File Name: test_touchpad_processing.c
+*
+* Description: Tests of the specialized touchpad processing
+* (ENABLE_TOUCHPAD_SPECIALIZED_PROCESSING) with its check against the generic
+* processing (ENABLE_TOUCHPAD_PROCESSING_CHECK). Recorded frames of difference
+* counts are replayed through the firmware main loop; in every frame the
+* firmware compares the touch status, touch count and positions of both and
+* counts the mismatches. On the host the generic processing is the model in
+* test/sim, which follows the same rules as the specialization, so this replay
+* is only a consistency check of the firmware against that model; it does not
+* validate the specialization against the middleware.
+*
+* The validation uses frames captured on the device with the results of the
+* middleware processing, for example Tuner logs of the touchpad. The
+* difference counts of every captured frame are processed by
+* update_touchpad_status() and its touch status, touch count and positions
+* must equal the captured ones. On the device ENABLE_TOUCHPAD_PROCESSING_CHECK
+* runs the same comparison in every frame.
+*
+* Usage: run [recording ...]
+* Without arguments the built-in recordings are replayed. A recording file has
+* one frame per line: "time_ms d0 d1 ... d19", the difference counts of the
+* nodes in the sensor order, held until the next line. A captured frame adds
+* the middleware results: "active n x0 y0 z0 id0 ... x(n-1) y(n-1) z(n-1)
+* id(n-1)". A line "thresholds finger_th hysteresis on_debounce" sets the
+* widget thresholds of the capture. Files with captured frames are compared
+* with the middleware results, the others are replayed as the built-in ones.
+*
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "sim.h"
+
+#define main firmware_main
+#include "main.c"
+#undef main
+#include "firmware_reset.h"
+
+#define MS(ms)                      SIM_US((uint64_t)(ms) * 1000u)
+
+#define RECORDING_MAX_FRAMES        (4096u)
+
+/* Touchdown time, in the ACTIVE state after the reset */
+#define RECORDING_START_MS          (500u)
+
+/* Difference count of a finger at a node and the finger radius in node pitches */
+#define FINGER_PEAK                 (1500.0)
+#define FINGER_RADIUS               (1.35)
+
+/* Modeled generic processing time and its status stage */
+#define PROCESS_WIDGET_US           (120u)
+#define PROCESS_STATUS_US           (50u)
+
+typedef struct
+{
+    double time;                    /* ms from the touchdown */
+    uint16_t diff[CY_CAPSENSE_TOUCHPAD_NUM_SNS];
+    uint8_t captured;               /* Non-zero with the middleware results */
+    TOUCHPAD_STATUS middleware;     /* Touch status and positions, the debounce is not captured */
+} recorded_frame_t;
+
+typedef struct
+{
+    char name[64];
+    uint32_t count;
+    uint32_t captured;              /* Frames with the results of the middleware */
+    uint16_t fingerTh;              /* Widget thresholds of the capture */
+    uint16_t hysteresis;
+    uint8_t onDebounce;
+    recorded_frame_t frame[RECORDING_MAX_FRAMES];
+} recording_t;
+
+typedef struct
+{
+    double x;                       /* Position in touchpad units */
+    double y;
+    double peak;                    /* Difference count at the finger center */
+} finger_t;
+
+static const recording_t *recording;
+static uint32_t noise_seed;
+
+/*******************************************************************************
+* Recordings
+*******************************************************************************/
+/* Repeatable uniform noise in [-amplitude, amplitude] */
+static double noise(double amplitude)
+{
+    noise_seed = noise_seed * 1103515245u + 12345u;
+    return amplitude * (((double)((noise_seed >> 8u) & 0xFFFFu) / 32767.5) - 1.0);
+}
+
+/* Difference counts of the fingers with noise, as the middleware reports them */
+static void render_frame(recorded_frame_t *ptrFrame, const finger_t *fingers, uint32_t count, double amplitude)
+{
+    uint32_t col;
+    uint32_t row;
+    uint32_t i;
+    double dx;
+    double dy;
+    double d;
+
+    for (col = 0u; col < TOUCHPAD_NUM_COLS; col++)
+    {
+        for (row = 0u; row < TOUCHPAD_NUM_ROWS; row++)
+        {
+            d = noise(amplitude);
+            for (i = 0u; i < count; i++)
+            {
+                dx = (fingers[i].x * (TOUCHPAD_NUM_COLS - 1u) / TOUCHPAD_MAX_POSITION) - col;
+                dy = (fingers[i].y * (TOUCHPAD_NUM_ROWS - 1u) / TOUCHPAD_MAX_POSITION) - row;
+                d += fingers[i].peak * fmax(0.0, 1.0 - ((dx * dx) + (dy * dy)) / (FINGER_RADIUS * FINGER_RADIUS));
+            }
+            ptrFrame->diff[(col * TOUCHPAD_NUM_ROWS) + row] = (uint16_t)fmin(fmax(floor(d + 0.5), 0.0), 4000.0);
+        }
+    }
+}
+
+/* Frames at the ACTIVE frame period of fingers given by a function of the time in ms */
+static void make_recording(recording_t *r, const char *name, double duration_ms, double amplitude,
+                           uint32_t (*fingers_at)(double ms, finger_t *fingers))
+{
+    finger_t fingers[CY_CAPSENSE_TOUCHPAD_NUM_TOUCHES];
+    double period = 1000.0 / ACTIVE_MODE_REFRESH_RATE;
+    uint32_t count;
+
+    memset(r, 0, sizeof(*r));
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    noise_seed = 1u;
+    for (r->count = 0u; (r->count < RECORDING_MAX_FRAMES) && ((r->count * period) < duration_ms); r->count++)
+    {
+        r->frame[r->count].time = r->count * period;
+        count = fingers_at(r->count * period, fingers);
+        render_frame(&r->frame[r->count], fingers, count, amplitude);
+    }
+}
+
+static uint32_t swipe_x(double ms, finger_t *f)
+{
+    f[0] = (finger_t){ TOUCHPAD_MAX_POSITION * fmin(ms / 600.0, 1.0), 128.0, FINGER_PEAK };
+    return (ms < 700.0) ? 1u : 0u;
+}
+
+static uint32_t swipe_corners(double ms, finger_t *f)
+{
+    double t = fmin(ms / 800.0, 1.0);
+
+    f[0] = (finger_t){ TOUCHPAD_MAX_POSITION * t, TOUCHPAD_MAX_POSITION * t, FINGER_PEAK };
+    return (ms < 900.0) ? 1u : 0u;
+}
+
+static uint32_t circle(double ms, finger_t *f)
+{
+    double a = 2.0 * M_PI * ms / 1000.0;
+
+    f[0] = (finger_t){ 128.0 + 100.0 * cos(a), 128.0 + 100.0 * sin(a), FINGER_PEAK };
+    return (ms < 1000.0) ? 1u : 0u;
+}
+
+static uint32_t two_fingers(double ms, finger_t *f)
+{
+    double t = fmin(ms / 800.0, 1.0);
+
+    f[0] = (finger_t){ 40.0 + 60.0 * t, 40.0, FINGER_PEAK };
+    f[1] = (finger_t){ 215.0 - 60.0 * t, 215.0, FINGER_PEAK * 0.8 };
+    return (ms < 900.0) ? 2u : 0u;
+}
+
+/* Taps of 15, 25 and 40 ms, around the on debounce */
+static uint32_t taps(double ms, finger_t *f)
+{
+    f[0] = (finger_t){ 90.0, 160.0, FINGER_PEAK };
+    return (((ms >= 0.0) && (ms < 15.0)) || ((ms >= 200.0) && (ms < 225.0)) || ((ms >= 400.0) && (ms < 440.0))) ?
+           1u : 0u;
+}
+
+/* A weak finger with its peak swinging around the finger threshold and the hysteresis */
+static uint32_t hover(double ms, finger_t *f)
+{
+    f[0] = (finger_t){ 170.0, 100.0, 690.0 + 120.0 * sin(2.0 * M_PI * ms / 300.0) };
+    return (ms < 1200.0) ? 1u : 0u;
+}
+
+/* Finger halfway between two nodes without noise: two equal maxima */
+static uint32_t plateau(double ms, finger_t *f)
+{
+    f[0] = (finger_t){ TOUCHPAD_MAX_POSITION / 6.0, TOUCHPAD_MAX_POSITION / 2.0, FINGER_PEAK };
+    return (ms < 300.0) ? 1u : 0u;
+}
+
+/* Touches at the start and 19.5 s later, after the ACTIVE and ALR timeouts */
+static uint32_t wot_touch(double ms, finger_t *f)
+{
+    f[0] = (finger_t){ 128.0, 128.0, FINGER_PEAK };
+    return ((ms < 300.0) || ((ms >= 19500.0) && (ms < 19800.0))) ? 1u : 0u;
+}
+
+static uint32_t no_finger(double ms, finger_t *f)
+{
+    (void)ms;
+    (void)f;
+    return 0u;
+}
+
+/* Parses the middleware results after the difference counts of a frame, if any.
+ * Returns zero if they are incomplete */
+static uint32_t parse_results(recorded_frame_t *ptrFrame, char *ptr)
+{
+    cy_stc_capsense_position_t *ptrPosition;
+    uint32_t value[2u + (4u * CY_CAPSENSE_TOUCHPAD_NUM_TOUCHES)];
+    uint32_t count;
+    char *end;
+
+    for (count = 0u; count < (sizeof(value) / sizeof(value[0])); count++)
+    {
+        value[count] = (uint32_t)strtoul(ptr, &end, 10);
+        if (end == ptr)
+        {
+            break;
+        }
+        ptr = end;
+    }
+    if ((count < 2u) || (value[1] > CY_CAPSENSE_TOUCHPAD_NUM_TOUCHES) || (count != (2u + (4u * value[1]))))
+    {
+        return (0u == count) ? 1u : 0u;
+    }
+
+    ptrFrame->captured = 1u;
+    ptrFrame->middleware.active = (uint8_t)(0u != value[0]);
+    ptrFrame->middleware.numPosition = (uint8_t)value[1];
+    for (count = 0u; count < value[1]; count++)
+    {
+        ptrPosition = &ptrFrame->middleware.position[count];
+        ptrPosition->x = (uint16_t)value[2u + (4u * count)];
+        ptrPosition->y = (uint16_t)value[3u + (4u * count)];
+        ptrPosition->z = (uint16_t)value[4u + (4u * count)];
+        ptrPosition->id = (uint16_t)value[5u + (4u * count)];
+    }
+    return 1u;
+}
+
+static int load_recording(recording_t *r, const char *path)
+{
+    FILE *file = fopen(path, "r");
+    char line[512];
+    char *ptr;
+    char *end;
+    double start = 0.0;
+    unsigned th[3];
+    uint32_t i;
+
+    if (NULL == file)
+    {
+        perror(path);
+        return -1;
+    }
+    memset(r, 0, sizeof(*r));
+    snprintf(r->name, sizeof(r->name), "%s", path);
+    r->fingerTh = CY_CAPSENSE_TOUCHPAD_FINGER_TH;
+    r->hysteresis = CY_CAPSENSE_TOUCHPAD_HYSTERESIS;
+    r->onDebounce = CY_CAPSENSE_TOUCHPAD_ON_DEBOUNCE;
+    while ((r->count < RECORDING_MAX_FRAMES) && (NULL != fgets(line, sizeof(line), file)))
+    {
+        recorded_frame_t *ptrFrame = &r->frame[r->count];
+
+        if (3 == sscanf(line, "thresholds %u %u %u", &th[0], &th[1], &th[2]))
+        {
+            r->fingerTh = (uint16_t)th[0];
+            r->hysteresis = (uint16_t)th[1];
+            r->onDebounce = (uint8_t)th[2];
+            continue;
+        }
+        ptrFrame->time = strtod(line, &end);
+        if (end == line)
+        {
+            continue;
+        }
+        for (i = 0u; i < CY_CAPSENSE_TOUCHPAD_NUM_SNS; i++)
+        {
+            ptr = end;
+            ptrFrame->diff[i] = (uint16_t)strtoul(ptr, &end, 10);
+            if (end == ptr)
+            {
+                break;
+            }
+        }
+        if ((CY_CAPSENSE_TOUCHPAD_NUM_SNS != i) || (0u == parse_results(ptrFrame, end)))
+        {
+            fprintf(stderr, "%s: skipped the line \"%.40s\"\n", path, line);
+            memset(ptrFrame, 0, sizeof(*ptrFrame));
+            continue;
+        }
+        start = (0u == r->count) ? ptrFrame->time : start;
+        ptrFrame->time -= start;
+        r->captured += ptrFrame->captured;
+        r->count++;
+    }
+    fclose(file);
+
+    if (0u == r->count)
+    {
+        fprintf(stderr, "%s: no frame\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+/*******************************************************************************
+* Replay
+*******************************************************************************/
+/* Recorded frame at the given virtual time, NULL before the first and after the last */
+static const recorded_frame_t *frame_at(uint64_t time)
+{
+    double ms;
+    uint32_t i;
+
+    if ((NULL == recording) || (time < MS(RECORDING_START_MS)))
+    {
+        return NULL;
+    }
+    ms = (double)(time - MS(RECORDING_START_MS)) / SIM_CYCLES_PER_US / 1000.0;
+
+    for (i = recording->count; i > 0u; i--)
+    {
+        if (ms >= recording->frame[i - 1u].time)
+        {
+            return ((i < recording->count) || (ms < (recording->frame[i - 1u].time + 1000.0 / ACTIVE_MODE_REFRESH_RATE))) ?
+                   &recording->frame[i - 1u] : NULL;
+        }
+    }
+    return NULL;
+}
+
+static void diff_source(uint64_t time, uint16_t *diffs)
+{
+    const recorded_frame_t *ptrFrame = frame_at(time);
+
+    if (NULL != ptrFrame)
+    {
+        memcpy(diffs, ptrFrame->diff, sizeof(ptrFrame->diff));
+    }
+    else
+    {
+        memset(diffs, 0, CY_CAPSENSE_TOUCHPAD_NUM_SNS * sizeof(uint16_t));
+    }
+}
+
+/* Wake-On-Touch scans see a touch on any node above the finger threshold */
+static uint32_t touch_source(uint64_t time, sim_touch_t *touches)
+{
+    const recorded_frame_t *ptrFrame = frame_at(time);
+    uint32_t i;
+
+    for (i = 0u; (NULL != ptrFrame) && (i < CY_CAPSENSE_TOUCHPAD_NUM_SNS); i++)
+    {
+        if (ptrFrame->diff[i] >= CY_CAPSENSE_TOUCHPAD_FINGER_TH)
+        {
+            touches[0] = (sim_touch_t){ 128u, 128u, 100u };
+            return 1u;
+        }
+    }
+    return 0u;
+}
+
+/* Frames with a touch reported by the specialized processing */
+static uint32_t touch_frames;
+
+static void count_touch_frame(void)
+{
+    static uint32_t last_frames;
+
+    if (host_interface.touchpadCheck.frames != last_frames)
+    {
+        last_frames = host_interface.touchpadCheck.frames;
+        touch_frames += (0u != touchpad_status.numPosition) ? 1u : 0u;
+    }
+}
+
+static void reset_firmware(void)
+{
+    firmware_reset();
+
+    sim_process_widget_cycles = SIM_US(PROCESS_WIDGET_US);
+    sim_process_status_cycles = SIM_US(PROCESS_STATUS_US);
+    sim_touchpad_diff_source = diff_source;
+    sim_touch_source = touch_source;
+    sim_sleep_hook = count_touch_frame;
+    touch_frames = 0u;
+}
+
+static void run_recording(const recording_t *r, uint32_t expect_touch)
+{
+    volatile TOUCHPAD_CHECK_REPORT *ptrReport = &host_interface.touchpadCheck;
+
+    reset_firmware();
+    recording = r;
+    sim_run(firmware_main, MS(RECORDING_START_MS) + SIM_US((uint64_t)(r->frame[r->count - 1u].time * 1000.0)) +
+            MS(200u));
+
+    printf("  %-28s %6u %6u %6u\n", r->name, (unsigned)ptrReport->frames, (unsigned)touch_frames,
+           (unsigned)ptrReport->mismatches);
+
+    SIM_CHECK(0u == (ptrReport->sequence & 1u));
+    SIM_CHECK(ptrReport->frames > 0u);
+    SIM_CHECK(0u == ptrReport->mismatches);
+    SIM_CHECK((0u != expect_touch) == (0u != touch_frames));
+}
+
+/*******************************************************************************
+* Captured middleware results
+*******************************************************************************/
+/* Processes every frame of a capture with the specialized processing, with the
+ * thresholds of the capture, and compares the results of the captured frames */
+static void compare_captured(const recording_t *r)
+{
+    cy_stc_capsense_widget_context_t *ptrWdCxt;
+    cy_stc_capsense_sensor_context_t *ptrSnsCxt;
+    const recorded_frame_t *ptrFrame;
+    TOUCHPAD_STATUS status;
+    uint32_t touches = 0u;
+    uint32_t mismatches = 0u;
+    uint32_t first_mismatch = 0u;
+    uint32_t mismatch;
+    uint32_t i;
+    uint32_t k;
+
+    firmware_reset();
+    ptrWdCxt = sim_widget_config[CY_CAPSENSE_TOUCHPAD_WDGT_ID].ptrWdContext;
+    ptrSnsCxt = sim_widget_config[CY_CAPSENSE_TOUCHPAD_WDGT_ID].ptrSnsContext;
+    ptrWdCxt->fingerTh = r->fingerTh;
+    ptrWdCxt->hysteresis = r->hysteresis;
+    ptrWdCxt->onDebounce = r->onDebounce;
+    memset(&status, 0, sizeof(status));
+
+    for (i = 0u; i < r->count; i++)
+    {
+        ptrFrame = &r->frame[i];
+        for (k = 0u; k < CY_CAPSENSE_TOUCHPAD_NUM_SNS; k++)
+        {
+            ptrSnsCxt[k].diff = ptrFrame->diff[k];
+        }
+        update_touchpad_status(&status);
+        if (0u == ptrFrame->captured)
+        {
+            continue;
+        }
+
+        touches += (0u != ptrFrame->middleware.numPosition) ? 1u : 0u;
+        mismatch = ((status.active != ptrFrame->middleware.active) ||
+                    (status.numPosition != ptrFrame->middleware.numPosition)) ? 1u : 0u;
+        for (k = 0u; (0u == mismatch) && (k < status.numPosition); k++)
+        {
+            mismatch = ((status.position[k].x != ptrFrame->middleware.position[k].x) ||
+                        (status.position[k].y != ptrFrame->middleware.position[k].y) ||
+                        (status.position[k].z != ptrFrame->middleware.position[k].z) ||
+                        (status.position[k].id != ptrFrame->middleware.position[k].id)) ? 1u : 0u;
+        }
+        if (0u != mismatch)
+        {
+            mismatches++;
+            first_mismatch = (0u == first_mismatch) ? (i + 1u) : first_mismatch;
+        }
+    }
+
+    printf("  %-28s %6u %6u %6u  first mismatch at frame %u\n", r->name, (unsigned)r->captured,
+           (unsigned)touches, (unsigned)mismatches, (unsigned)first_mismatch);
+    SIM_CHECK(0u == mismatches);
+}
+
+int main(int argc, char **argv)
+{
+    static recording_t recordings[8];
+    volatile TOUCHPAD_CHECK_REPORT *ptrReport = &host_interface.touchpadCheck;
+    uint32_t failures;
+    uint32_t asserts;
+    uint32_t count = 0u;
+    int i;
+
+    if (argc > 1)
+    {
+        printf("Specialized touchpad processing vs the results captured from the middleware,\n"
+               "or vs the model of the generic processing for files without captured results\n");
+        printf("  %-28s %6s %6s %6s\n", "recording", "frames", "touch", "diffs");
+        for (i = 1; (i < argc) && (count < 8u); i++)
+        {
+            if (0 != load_recording(&recordings[count], argv[i]))
+            {
+                return 1;
+            }
+            if (0u != recordings[count].captured)
+            {
+                compare_captured(&recordings[count]);
+            }
+            else
+            {
+                run_recording(&recordings[count], 1u);
+            }
+            count++;
+        }
+        return sim_report("test_touchpad_processing");
+    }
+
+    printf("Specialized touchpad processing vs the model of the generic processing, a consistency check\n");
+    printf("  %-28s %6s %6s %6s\n", "recording", "frames", "touch", "diffs");
+
+    make_recording(&recordings[0], "swipe x, noise 60", 800.0, 60.0, swipe_x);
+    run_recording(&recordings[0], 1u);
+    make_recording(&recordings[1], "swipe corner to corner", 1000.0, 60.0, swipe_corners);
+    run_recording(&recordings[1], 1u);
+    make_recording(&recordings[2], "circle r 100", 1100.0, 60.0, circle);
+    run_recording(&recordings[2], 1u);
+    make_recording(&recordings[3], "two fingers", 1000.0, 60.0, two_fingers);
+    run_recording(&recordings[3], 1u);
+    make_recording(&recordings[4], "taps 15, 25, 40 ms", 600.0, 40.0, taps);
+    run_recording(&recordings[4], 1u);
+    make_recording(&recordings[5], "hover around threshold", 1300.0, 30.0, hover);
+    run_recording(&recordings[5], 1u);
+    make_recording(&recordings[6], "two equal maxima", 400.0, 0.0, plateau);
+    run_recording(&recordings[6], 1u);
+    make_recording(&recordings[7], "noise 300, no finger", 600.0, 300.0, no_finger);
+    run_recording(&recordings[7], 0u);
+
+    /* A configuration that no longer matches the specialization fails the assert at the initialization and the
+     * comparison. The assert counts as a failure of the model, it is taken back */
+    reset_firmware();
+    sim_widget_config[CY_CAPSENSE_TOUCHPAD_WDGT_ID].xResolution = 2u * TOUCHPAD_MAX_POSITION;
+    recording = &recordings[0];
+    failures = sim_failures;
+    sim_run(firmware_main, MS(RECORDING_START_MS + 1000u));
+    asserts = sim_failures - failures;
+    sim_failures = failures;
+    printf("  %-28s %6u %6s %6u  %u assert\n", "x resolution changed", (unsigned)ptrReport->frames, "",
+           (unsigned)ptrReport->mismatches, (unsigned)asserts);
+    SIM_CHECK(1u == asserts);
+    SIM_CHECK(ptrReport->mismatches > 0u);
+    SIM_CHECK(0u != ptrReport->lastMismatchFrame);
+
+    /* A position filter is detected by the assert alone */
+    reset_firmware();
+    sim_widget_config[CY_CAPSENSE_TOUCHPAD_WDGT_ID].posFilterConfig = 0x01u;
+    recording = &recordings[7];
+    failures = sim_failures;
+    sim_run(firmware_main, MS(RECORDING_START_MS + 100u));
+    asserts = sim_failures - failures;
+    sim_failures = failures;
+    printf("  %-28s %6u %6s %6u  %u assert\n", "position filter enabled", (unsigned)ptrReport->frames, "",
+           (unsigned)ptrReport->mismatches, (unsigned)asserts);
+    SIM_CHECK(1u == asserts);
+
+    /* Only the touchpad is processed, so the low power widget stays active after a
+     * touch in the WOT state; the state machine must still return to WOT. Touches
+     * at 0.5 s in ACTIVE and at 20 s in WOT, WOT from about 15.5 s and 35.3 s. The
+     * CPU stays in Deep Sleep over the WOT frame, the run stops once it ends */
+    reset_firmware();
+    make_recording(&recordings[0], "touch in WOT", 19900.0, 0.0, wot_touch);
+    recording = &recordings[0];
+    sim_run(firmware_main, MS(40000u));
+    printf("  WOT entries with a touch in WOT: %u\n", (unsigned)sim_wot_count);
+    SIM_CHECK(2u == sim_wot_count);
+    SIM_CHECK(sim_wot_start_time > MS(20000u));
+
+    return sim_report("test_touchpad_processing");
+}
@@ -0,0 +1,223 @@
+/******************************************************************************
+* File Name: test_tuner_snapshot.c
+*
+* Description: Tests of the Tuner snapshot publication (ENABLE_TUNER_SNAPSHOT)
+* against the EZI2C model: host writes reach the live CAPSENSE data, also
+* when they rewrite the value read, are never lost or applied partially around
+* a buffer swap, and the Tuner suspend/resume handshake completes as with the
+* direct buffer.
+*
+*******************************************************************************/
+#include "sim.h"
+
+#define main firmware_main
+#include "main.c"
+#undef main
+#include "firmware_reset.h"
+
+#define WIDGET_OFFSET(member)   (offsetof(cy_stc_capsense_tuner_t, wdgtContext[CY_CAPSENSE_TOUCHPAD_WDGT_ID]) + \
+                                 offsetof(cy_stc_capsense_widget_context_t, member))
+#define COMMON_OFFSET(member)   (offsetof(cy_stc_capsense_tuner_t, commonContext) + \
+                                 offsetof(cy_stc_capsense_common_context_t, member))
+
+static cy_stc_capsense_tuner_t host_view;
+
+static void setup(void)
+{
+    firmware_reset();
+    __enable_irq();
+    cy_capsense_tuner.wdgtContext[CY_CAPSENSE_TOUCHPAD_WDGT_ID].fingerTh = CY_CAPSENSE_TOUCHPAD_FINGER_TH;
+    initialize_capsense_tuner();
+    initialize_capsense();
+}
+
+static void host_read_all(void)
+{
+    sim_host_read(SIM_EZI2C_BUFFER1, 0u, &host_view, sizeof(host_view));
+}
+
+static void host_write_u16(uint32_t offset, uint16_t value)
+{
+    sim_host_write(SIM_EZI2C_BUFFER1, offset, &value, sizeof(value));
+}
+
+/* A parameter written by the host reaches the live data and the published snapshots */
+static void test_write_is_merged(void)
+{
+    setup();
+    tuner_task();
+
+    host_write_u16(WIDGET_OFFSET(fingerTh), 900u);
+    tuner_task();
+    SIM_CHECK(900u == cy_capsense_tuner.wdgtContext[CY_CAPSENSE_TOUCHPAD_WDGT_ID].fingerTh);
+
+    host_read_all();
+    SIM_CHECK(900u == host_view.wdgtContext[CY_CAPSENSE_TOUCHPAD_WDGT_ID].fingerTh);
+
+    /* Published again, the value must stay */
+    tuner_task();
+    tuner_task();
+    host_read_all();
+    SIM_CHECK(900u == host_view.wdgtContext[CY_CAPSENSE_TOUCHPAD_WDGT_ID].fingerTh);
+    SIM_CHECK(900u == cy_capsense_tuner.wdgtContext[CY_CAPSENSE_TOUCHPAD_WDGT_ID].fingerTh);
+}
+
+/* A write completed while the back snapshot is filled is not lost with the front one */
+static uint32_t race_armed;
+
+static void write_before_swap(void)
+{
+    if (0u != race_armed)
+    {
+        race_armed = 0u;
+        host_write_u16(WIDGET_OFFSET(hysteresis), 77u);
+    }
+}
+
+static void test_write_during_publish(void)
+{
+    uint32_t front;
+
+    setup();
+    tuner_task();
+
+    /* The critical section of publish_tuner_snapshot() is the swap, after the back snapshot is filled */
+    front = tuner_front;
+    race_armed = 1u;
+    sim_critical_section_hook = write_before_swap;
+    publish_tuner_snapshot();
+    sim_critical_section_hook = NULL;
+
+    SIM_CHECK(0u == race_armed);
+    SIM_CHECK(front == tuner_front);
+
+    SIM_CHECK(77u == cy_capsense_tuner.wdgtContext[CY_CAPSENSE_TOUCHPAD_WDGT_ID].hysteresis);
+    tuner_task();
+
+    host_read_all();
+    SIM_CHECK(77u == host_view.wdgtContext[CY_CAPSENSE_TOUCHPAD_WDGT_ID].hysteresis);
+}
+
+/* A parameter is applied only once its write is complete */
+static void test_partial_write(void)
+{
+    uint16_t value = 0x1234u;
+
+    setup();
+    tuner_task();
+    host_write_u16(WIDGET_OFFSET(noiseTh), 0u);
+    tuner_task();
+
+    sim_ezi2c_start(SIM_EZI2C_BUFFER1, 1u, WIDGET_OFFSET(noiseTh));
+    sim_ezi2c_write(&value, 1u);
+    tuner_task();
+    tuner_task();
+    SIM_CHECK(0u == cy_capsense_tuner.wdgtContext[CY_CAPSENSE_TOUCHPAD_WDGT_ID].noiseTh);
+
+    sim_ezi2c_write((uint8_t *)&value + 1u, 1u);
+    sim_ezi2c_stop();
+    tuner_task();
+    SIM_CHECK(0x1234u == cy_capsense_tuner.wdgtContext[CY_CAPSENSE_TOUCHPAD_WDGT_ID].noiseTh);
+}
+
+/* A rewrite of the value read is applied, as with the direct buffer, even if the live data changed since */
+static void test_same_value_rewrite(void)
+{
+    uint16_t threshold;
+
+    setup();
+    tuner_task();
+
+    host_read_all();
+    threshold = host_view.wdgtContext[CY_CAPSENSE_TOUCHPAD_WDGT_ID].fingerTh;
+    cy_capsense_tuner.wdgtContext[CY_CAPSENSE_TOUCHPAD_WDGT_ID].fingerTh = threshold + 10u;
+    cy_capsense_tuner.wdgtContext[CY_CAPSENSE_TOUCHPAD_WDGT_ID].hysteresis = 33u;
+
+    host_write_u16(WIDGET_OFFSET(fingerTh), threshold);
+
+    SIM_CHECK(threshold == cy_capsense_tuner.wdgtContext[CY_CAPSENSE_TOUCHPAD_WDGT_ID].fingerTh);
+    /* The bytes around the write are kept */
+    SIM_CHECK(33u == cy_capsense_tuner.wdgtContext[CY_CAPSENSE_TOUCHPAD_WDGT_ID].hysteresis);
+}
+
+/* The command acknowledgement is visible as soon as the task returns */
+static void test_ack_not_delayed(void)
+{
+    setup();
+    tuner_task();
+
+    host_write_u16(COMMON_OFFSET(tunerCmd), CY_CAPSENSE_TU_CMD_PING_E);
+    tuner_task();
+    host_read_all();
+    SIM_CHECK(CY_CAPSENSE_TU_CMD_NONE_E == host_view.commonContext.tunerCmd);
+}
+
+/* Host side of the Tuner suspend/resume handshake, run from the suspend loop */
+typedef enum
+{
+    HOST_WAIT_SUSPENDED,
+    HOST_WAIT_RESUMED
+} host_state_t;
+
+static host_state_t host_state;
+static uint32_t host_polls;
+
+static void tuner_host(void)
+{
+    cy_stc_capsense_common_context_t common;
+
+    sim_host_read(SIM_EZI2C_BUFFER1, COMMON_OFFSET(configId), &common, sizeof(common));
+    host_polls++;
+
+    switch (host_state)
+    {
+        case HOST_WAIT_SUSPENDED:
+            if ((CY_CAPSENSE_TU_CMD_NONE_E == common.tunerCmd) && (CY_CAPSENSE_TU_FSM_SUSPENDED == common.tunerSt))
+            {
+                host_write_u16(WIDGET_OFFSET(fingerTh), 500u);
+                host_write_u16(COMMON_OFFSET(tunerCmd), CY_CAPSENSE_TU_CMD_RESUME_E);
+                host_state = HOST_WAIT_RESUMED;
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void test_suspend_resume(void)
+{
+    setup();
+    tuner_task();
+
+    host_state = HOST_WAIT_SUSPENDED;
+    host_polls = 0u;
+    host_write_u16(COMMON_OFFSET(tunerCmd), CY_CAPSENSE_TU_CMD_SUSPEND_E);
+
+    sim_tuner_loop_hook = tuner_host;
+    tuner_task();
+    sim_tuner_loop_hook = NULL;
+
+    SIM_CHECK(HOST_WAIT_RESUMED == host_state);
+    SIM_CHECK(host_polls < 10u);
+    SIM_CHECK(CY_CAPSENSE_TU_FSM_RUNNING == cy_capsense_tuner.commonContext.tunerSt);
+    SIM_CHECK(500u == cy_capsense_tuner.wdgtContext[CY_CAPSENSE_TOUCHPAD_WDGT_ID].fingerTh);
+
+    /* The resume acknowledgement is published with the task */
+    host_read_all();
+    SIM_CHECK(CY_CAPSENSE_TU_CMD_NONE_E == host_view.commonContext.tunerCmd);
+    SIM_CHECK(CY_CAPSENSE_TU_FSM_RUNNING == host_view.commonContext.tunerSt);
+    SIM_CHECK(500u == host_view.wdgtContext[CY_CAPSENSE_TOUCHPAD_WDGT_ID].fingerTh);
+}
+
+int main(void)
+{
+    test_write_is_merged();
+    test_write_during_publish();
+    test_partial_write();
+    test_same_value_rewrite();
+    test_ack_not_delayed();
+    test_suspend_resume();
+
+    return sim_report("test_tuner_snapshot");
+}